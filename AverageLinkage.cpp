@@ -0,0 +1,168 @@
+/*
+Armon Azizi
+
+AverageLinkage.cpp
+
+This class clusters a GenomeNetwork with average linkage (UPGMA),
+using the nearest neighbor chain algorithm over a dense upper
+triangular matrix of homologies.
+*/
+
+#include "AverageLinkage.h"
+#include "GenomeNetwork.h"
+
+#include <vector>
+#include <tuple>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+using namespace std;
+
+AverageLinkage::AverageLinkage() {
+	n = 0;
+}
+
+AverageLinkage::~AverageLinkage() {
+}
+
+//Position of pair (i, j) in the upper triangular matrix
+size_t AverageLinkage::index(unsigned int i, unsigned int j) {
+
+	if (i > j)
+		swap(i, j);
+
+	return (size_t)i * (2 * (size_t)n - i - 1) / 2 + (j - i - 1);
+}
+
+//Return the representative of x, halving the path on the way up
+static unsigned int findRoot(vector<unsigned int> &parent, unsigned int x) {
+
+	while (parent[x] != x) {
+		parent[x] = parent[parent[x]];
+		x = parent[x];
+	}
+
+	return x;
+}
+
+/*
+Cluster the network into num_clusters families.
+
+A merged family takes the slot of one of its two halves, the other slot
+is removed from the list of active families.
+*/
+vector<unsigned int> AverageLinkage::cluster(GenomeNetwork &net, int num_clusters) {
+
+	n = net.numNodes();
+
+	//Fill the matrix, missing pairs have no homology
+	homologies.assign(n > 1 ? (size_t)n * (n - 1) / 2 : 0, 0);
+
+	for (auto &e : net.getEdges())
+		if (e.gen1 != e.gen2 && !isnan(e.homology))
+			homologies[index(e.gen1, e.gen2)] = e.homology;
+
+	//Active families, with the position of each one in the list
+	vector<unsigned int> active(n);
+	vector<unsigned int> position(n);
+	vector<unsigned int> size(n, 1);
+
+	iota(active.begin(), active.end(), 0);
+	iota(position.begin(), position.end(), 0);
+
+	//Every merge as (homology, kept slot, removed slot)
+	vector<tuple<float, unsigned int, unsigned int>> merges;
+	vector<unsigned int> chain;
+
+	while (active.size() > 1) {
+
+		if (chain.empty())
+			chain.push_back(active[0]);
+
+		unsigned int a = chain.back();
+		unsigned int previous = chain.size() > 1 ? chain[chain.size() - 2] : a;
+
+		//Find the most homologous family of a, preferring the previous
+		//family in the chain on ties so the chain always ends.
+		unsigned int best = previous;
+		float bestHomology = previous != a ? homologies[index(a, previous)] : -HUGE_VALF;
+
+		for (unsigned int c : active) {
+
+			if (c == a) continue;
+
+			float h = homologies[index(a, c)];
+
+			if (h > bestHomology) {
+				bestHomology = h;
+				best = c;
+			}
+		}
+
+		if (best != previous) {
+			chain.push_back(best);
+			continue;
+		}
+
+		//a and previous are each other's nearest neighbors, merge them
+		chain.pop_back();
+		chain.pop_back();
+
+		unsigned int kept = min(a, best);
+		unsigned int removed = max(a, best);
+
+		merges.push_back(make_tuple(bestHomology, kept, removed));
+
+		//Remove the second half from the active list
+		unsigned int last = active.back();
+
+		active[position[removed]] = last;
+		position[last] = position[removed];
+		active.pop_back();
+
+		//Average homology of the new family to every other family
+		float keptSize = size[kept];
+		float removedSize = size[removed];
+
+		for (unsigned int c : active) {
+
+			if (c == kept) continue;
+
+			float &h = homologies[index(kept, c)];
+
+			h = (keptSize * h + removedSize * homologies[index(removed, c)])
+				/ (keptSize + removedSize);
+		}
+
+		size[kept] += size[removed];
+	}
+
+	vector<float>().swap(homologies);
+
+	//Apply the strongest merges until num_clusters families are left
+	stable_sort(merges.begin(), merges.end(),
+		[](const tuple<float, unsigned int, unsigned int> &lhs,
+			const tuple<float, unsigned int, unsigned int> &rhs) {
+			return get<0>(lhs) > get<0>(rhs);
+		});
+
+	vector<unsigned int> parent(n);
+
+	iota(parent.begin(), parent.end(), 0);
+
+	for (size_t m = 0; m + num_clusters < n && m < merges.size(); ++m) {
+
+		unsigned int r1 = findRoot(parent, get<1>(merges[m]));
+		unsigned int r2 = findRoot(parent, get<2>(merges[m]));
+
+		parent[max(r1, r2)] = min(r1, r2);
+	}
+
+	vector<unsigned int> labels(n);
+
+	for (unsigned int i = 0; i < n; ++i)
+		labels[i] = findRoot(parent, i);
+
+	return labels;
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+/*
+Armon Azizi
+
+AverageLinkage.h
+
+This class clusters a GenomeNetwork with average linkage (UPGMA).
+
+Starting with every genome in its own family, the two families with
+the highest average homology between their members are merged, until
+only the requested number of families is left. Unlike trimming single
+edges, one very homologous pair of genomes is not enough to join two
+families, the whole families have to be similar.
+
+The homologies are stored in a dense upper triangular float matrix.
+Pairs missing from the input count as zero homology. When two families
+merge, the homology of the new family to every other family is the
+size weighted average of the two old ones, so the matrix is updated
+in place.
+
+Merges are found with the nearest neighbor chain algorithm: follow a
+chain of families, each one the most homologous family of the one
+before, until two families are each other's most homologous family.
+Those two can be merged right away. This takes O(N^2) time and needs
+no priority queue. The merges don't come out in order, so at the end
+they are sorted by homology and the strongest N - num_clusters are
+applied.
+*/
+
+#ifndef AVERAGELINKAGE_H
+#define AVERAGELINKAGE_H
+
+#include "GenomeNetwork.h"
+
+#include <vector>
+
+using namespace std;
+
+class AverageLinkage {
+
+private:
+	//Number of genomes
+	unsigned int n;
+
+	//Upper triangular homology matrix, row by row without the diagonal
+	vector<float> homologies;
+
+	//Return the position of pair (i, j) in the matrix, i != j
+	size_t index(unsigned int i, unsigned int j);
+
+public:
+
+	AverageLinkage();
+
+	~AverageLinkage();
+
+	/*
+	Cluster the network into num_clusters families.
+
+	Return the family label of every genome id. Genomes with the same
+	label are in the same family.
+	*/
+	vector<unsigned int> cluster(GenomeNetwork &net, int num_clusters);
+
+};
+
+
+#endif // AVERAGELINKAGE_H
\ No newline at end of file
@@ -0,0 +1,110 @@
+/*
+Armon Azizi
+
+ConnectedComponents.cpp
+
+Finds the connected components of a graph given as a contiguous
+array of edges, using several threads.
+
+Components are trees of parent pointers. Roots are only ever linked
+below a root with a smaller id, so the root of every component is its
+smallest node id and there are never cycles, even when threads link
+the same components at the same time.
+*/
+
+#include "ConnectedComponents.h"
+#include "GenomeNetwork.h"
+#include "Parallel.h"
+
+#include <vector>
+#include <atomic>
+
+using namespace std;
+
+//Number of edges or nodes handed to a thread at a time
+static const size_t EDGE_GRAIN = 1 << 14;
+static const size_t NODE_GRAIN = 1 << 16;
+
+/*
+Join the components of u and v.
+
+Walk both nodes up towards their roots. When the larger of the two
+current nodes is a root, try to point it at the smaller one. If another
+thread changed it first, keep walking from where it points now.
+*/
+static void link(unsigned int u, unsigned int v, vector<atomic<unsigned int>> &parent) {
+
+	unsigned int p1 = parent[u].load(memory_order_relaxed);
+	unsigned int p2 = parent[v].load(memory_order_relaxed);
+
+	while (p1 != p2) {
+
+		unsigned int high = p1 > p2 ? p1 : p2;
+		unsigned int low = p1 > p2 ? p2 : p1;
+
+		unsigned int highParent = parent[high].load(memory_order_relaxed);
+
+		//Already linked
+		if (highParent == low)
+			break;
+
+		//high is a root, link it below low
+		if (highParent == high && parent[high].compare_exchange_strong(highParent, low))
+			break;
+
+		p1 = parent[parent[high].load(memory_order_relaxed)].load(memory_order_relaxed);
+		p2 = parent[low].load(memory_order_relaxed);
+	}
+}
+
+//Label the connected components of the graph
+unsigned int connectedComponents(unsigned int numNodes, const HomologyEdge * edges,
+	size_t numEdges, int numThreads, vector<unsigned int> &labels) {
+
+	vector<atomic<unsigned int>> parent(numNodes);
+
+	//Every node starts as its own component
+	parallelFor(numNodes, NODE_GRAIN, numThreads, [&](size_t begin, size_t end, int) {
+		for (size_t i = begin; i < end; ++i)
+			parent[i].store(i, memory_order_relaxed);
+	});
+
+	//Link the ends of every edge
+	parallelFor(numEdges, EDGE_GRAIN, numThreads, [&](size_t begin, size_t end, int) {
+		for (size_t e = begin; e < end; ++e)
+			link(edges[e].gen1, edges[e].gen2, parent);
+	});
+
+	//Point every node straight at its root and count the roots
+	labels.resize(numNodes);
+
+	vector<unsigned int> blockRoots((numNodes + NODE_GRAIN - 1) / NODE_GRAIN, 0);
+
+	parallelFor(numNodes, NODE_GRAIN, numThreads, [&](size_t begin, size_t end, int) {
+
+		unsigned int roots = 0;
+
+		for (size_t i = begin; i < end; ++i) {
+
+			unsigned int root = parent[i].load(memory_order_relaxed);
+
+			while (root != parent[root].load(memory_order_relaxed))
+				root = parent[root].load(memory_order_relaxed);
+
+			parent[i].store(root, memory_order_relaxed);
+			labels[i] = root;
+
+			if (root == i)
+				++roots;
+		}
+
+		blockRoots[begin / NODE_GRAIN] = roots;
+	});
+
+	unsigned int numComponents = 0;
+
+	for (unsigned int roots : blockRoots)
+		numComponents += roots;
+
+	return numComponents;
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+/*
+Armon Azizi
+
+ConnectedComponents.h
+
+Finds the connected components of a graph given as a contiguous
+array of edges, using several threads.
+
+Every node starts as its own component. Threads walk over blocks of
+the edge array and link the components of both ends of every edge by
+pointing the root with the larger id at the root with the smaller id
+with an atomic compare and swap, as in the Afforest and
+Shiloach-Vishkin algorithms. A final pass compresses every node's path
+so it points straight at its root.
+
+No adjacency lists are needed and nothing is recursive, so the size
+of a component doesn't matter.
+*/
+
+#ifndef CONNECTEDCOMPONENTS_H
+#define CONNECTEDCOMPONENTS_H
+
+#include "GenomeNetwork.h"
+
+#include <vector>
+
+using namespace std;
+
+/*
+Label the connected components of the graph with numNodes nodes
+and the edges in [edges, edges + numEdges).
+
+Every node is labeled with the smallest node id in its component.
+Return the number of components.
+*/
+unsigned int connectedComponents(unsigned int numNodes, const HomologyEdge * edges,
+	size_t numEdges, int numThreads, vector<unsigned int> &labels);
+
+
+#endif // CONNECTEDCOMPONENTS_H
\ No newline at end of file
@@ -0,0 +1,110 @@
+/*
+Armon Azizi
+
+ContainmentSampler.cpp
+
+Estimates the proportion of a genome's sequences found in an index
+from a random sample of its sequences.
+*/
+
+#include "ContainmentSampler.h"
+#include "KmerScanner.h"
+
+#include <string>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <utility>
+
+using namespace std;
+
+//Sequences searched for between checks of the interval
+const size_t SAMPLE_BATCH = 512;
+
+//Normal quantile of a 95% interval
+const double Z = 1.96;
+
+ContainmentSampler::ContainmentSampler(double tolerance, uint64_t seed)
+	: tolerance(tolerance), seed(seed) {}
+
+void ContainmentSampler::load(const string &fileName, const vector<int> &seqLens, unsigned int genome) {
+
+	size_t numLengths = seqLens.size();
+
+	codes.assign(numLengths, vector<uint64_t>());
+	valid.assign(numLengths, vector<char>());
+
+	auto onSequence = [&](size_t l, uint64_t code, bool isValid) {
+		codes[l].push_back(code);
+		valid[l].push_back(isValid);
+	};
+
+	if (numLengths == 1)
+		dispatchLength(seqLens[0], [&](auto length) {
+			scanSequences(fileName, length, length, [&](uint64_t code, bool isValid) {
+				onSequence(0, code, isValid);
+			});
+		});
+	else
+		scanSequences(fileName, seqLens, seqLens, onSequence);
+
+	//The order only depends on the seed and the genome
+	for (size_t l = 0; l < numLengths; ++l) {
+
+		mt19937_64 generator(hashSequence(seed) ^ hashSequence(((uint64_t)genome << 8) | l));
+
+		for (size_t i = codes[l].size(); i > 1; --i) {
+
+			size_t j = generator() % i;
+
+			swap(codes[l][i - 1], codes[l][j]);
+			swap(valid[l][i - 1], valid[l][j]);
+		}
+	}
+}
+
+void ContainmentSampler::sample(KmerIndex &index, size_t l, size_t &mapped, size_t &drawn) {
+
+	mapped = 0;
+	drawn = 0;
+
+	size_t count = codes[l].size();
+
+	vector<uint64_t> batch;
+	batch.reserve(SAMPLE_BATCH);
+
+	while (drawn < count) {
+
+		size_t end = min(count, drawn + SAMPLE_BATCH);
+
+		//Invalid sequences are drawn but never found
+		batch.clear();
+
+		for (size_t i = drawn; i < end; ++i)
+			if (valid[l][i])
+				batch.push_back(codes[l][i]);
+
+		mapped += index.countFound(batch.data(), batch.size());
+		drawn = end;
+
+		if (halfWidth(mapped, drawn, count) <= tolerance)
+			break;
+	}
+}
+
+double ContainmentSampler::halfWidth(size_t mapped, size_t drawn, size_t total) {
+
+	if (drawn == 0)
+		return 1;
+
+	double n = drawn;
+	double p = mapped / n;
+
+	double half = Z * sqrt(p * (1 - p) / n + Z * Z / (4 * n * n)) / (1 + Z * Z / n);
+
+	//Sampling without replacement from a finite genome
+	if (total > 1)
+		half *= sqrt((double)(total - drawn) / (double)(total - 1));
+
+	return half;
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+/*
+Armon Azizi
+
+ContainmentSampler.h
+
+Estimates the proportion of a genome's sequences found in an index
+from a random sample of its sequences, instead of searching for all of
+them.
+
+The sequences getMappedPercentage would search for are read once and
+shuffled in an order that only depends on the seed and the genome, so
+runs are reproducible. Sequences are then searched for in that order,
+a batch at a time, while a 95% Wilson score interval is kept on the
+proportion found. Sampling stops once the interval is within the
+tolerance on both sides, or when every sequence has been searched for.
+
+The 95% is nominal: it holds for an interval checked once, but the
+interval is checked after every batch and sampling stops at the first
+batch that looks precise enough, so the actual coverage is somewhat
+lower. A smaller tolerance makes up for it.
+
+The interval includes the finite population correction, so it shrinks
+to nothing once the whole genome has been searched. Genomes that share
+almost nothing with the index stop after a couple of thousand
+sequences.
+*/
+
+#ifndef CONTAINMENTSAMPLER_H
+#define CONTAINMENTSAMPLER_H
+
+#include "KmerIndex.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+class ContainmentSampler {
+
+public:
+
+	//tolerance is the largest half width of the interval, as a proportion
+	ContainmentSampler(double tolerance, uint64_t seed);
+
+	//Read and shuffle the sequences of every length of a genome, all at most 32 long
+	void load(const string &fileName, const vector<int> &seqLens, unsigned int genome);
+
+	//Number of sequences of length l in the genome, the total getMappedPercentage divides by
+	size_t total(size_t l) { return codes[l].size(); }
+
+	/*
+	Search for sequences of length l in the index until the proportion found
+	is known to within the tolerance. Set mapped to the number found and
+	drawn to the number searched for.
+	*/
+	void sample(KmerIndex &index, size_t l, size_t &mapped, size_t &drawn);
+
+	//Half width of the nominal 95% interval after finding mapped of drawn sequences out of total
+	static double halfWidth(size_t mapped, size_t drawn, size_t total);
+
+private:
+
+	double tolerance;
+
+	uint64_t seed;
+
+	//Shuffled sequences of every length, and whether each one is valid
+	vector<vector<uint64_t>> codes;
+	vector<vector<char>> valid;
+};
+
+
+#endif // CONTAINMENTSAMPLER_H
\ No newline at end of file
@@ -0,0 +1,329 @@
+/*
+Armon Azizi
+
+ExternalClustering.cpp
+
+This class clusters a homology table with single linkage, like
+GenomeNetwork::cluster, without holding its edges in memory.
+
+Runs are sorted by decreasing homology with equal homologies in reverse
+input order. While runs are merged, equal homologies are taken from the
+later run first, so the merged edges come out in exactly the reverse
+order of the sorted edge array of GenomeNetwork.
+*/
+
+#include "ExternalClustering.h"
+#include "HomologyParser.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <queue>
+#include <memory>
+#include <fstream>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+//Most runs merged at once, so the number of open files stays small
+const size_t MAX_MERGE_WIDTH = 64;
+
+//Edges read from a run file at once
+const size_t RUN_BUFFER_EDGES = 1 << 12;
+
+//Reads the edges of a run file in order, a buffer at a time
+struct RunReader {
+
+	ifstream in;
+
+	vector<HomologyEdge> buffer;
+
+	size_t next;
+	size_t count;
+
+	RunReader(const string &fileName)
+		: in(fileName, ios::binary), buffer(RUN_BUFFER_EDGES), next(0), count(0) {}
+
+	//Read the next edge. Return false at the end of the run.
+	bool read(HomologyEdge &edge) {
+
+		if (next == count) {
+
+			in.read((char *)buffer.data(), buffer.size() * sizeof(HomologyEdge));
+
+			count = in.gcount() / sizeof(HomologyEdge);
+			next = 0;
+
+			if (count == 0) return false;
+		}
+
+		edge = buffer[next++];
+
+		return true;
+	}
+};
+
+ExternalClustering::ExternalClustering(size_t memLimit, const string &runPrefix)
+	: bufferEdges(max((size_t)1, memLimit / sizeof(HomologyEdge))), runPrefix(runPrefix),
+	numEdges(0), appliedEdges(0) {}
+
+ExternalClustering::~ExternalClustering() {
+	removeRuns();
+}
+
+//Sort the buffer by decreasing homology, equal homologies in reverse input order
+bool ExternalClustering::writeRun(vector<HomologyEdge> &buffer) {
+
+	reverse(buffer.begin(), buffer.end());
+
+	stable_sort(buffer.begin(), buffer.end(),
+		[](const HomologyEdge &lhs, const HomologyEdge &rhs) {
+			return lhs.homology > rhs.homology;
+		});
+
+	string runName = runPrefix + to_string(runs.size());
+
+	ofstream out(runName, ios::binary);
+
+	out.write((const char *)buffer.data(), buffer.size() * sizeof(HomologyEdge));
+
+	runs.push_back(runName);
+
+	buffer.clear();
+
+	if (!out) {
+		cout << "could not write " << runName << endl;
+		return false;
+	}
+
+	return true;
+}
+
+/*
+Merge runs with a heap holding the next edge of every run.
+
+The heap is ordered by homology, and by run for equal homologies,
+so the edges of later runs come first.
+*/
+template<typename EdgeFn>
+bool ExternalClustering::mergeRuns(size_t first, size_t last, EdgeFn onEdge) {
+
+	struct Head {
+		HomologyEdge edge;
+		size_t run;
+	};
+
+	auto after = [](const Head &lhs, const Head &rhs) {
+		if (lhs.edge.homology != rhs.edge.homology)
+			return lhs.edge.homology < rhs.edge.homology;
+		return lhs.run < rhs.run;
+	};
+
+	priority_queue<Head, vector<Head>, decltype(after)> heads(after);
+
+	vector<unique_ptr<RunReader>> readers;
+
+	for (size_t r = first; r < last; ++r) {
+
+		readers.emplace_back(new RunReader(runs[r]));
+
+		if (!readers.back()->in) {
+			cout << "could not read " << runs[r] << endl;
+			return false;
+		}
+
+		Head head;
+		head.run = r - first;
+
+		if (readers.back()->read(head.edge))
+			heads.push(head);
+	}
+
+	while (!heads.empty()) {
+
+		Head head = heads.top();
+		heads.pop();
+
+		if (!onEdge(head.edge))
+			break;
+
+		if (readers[head.run]->read(head.edge))
+			heads.push(head);
+	}
+
+	return true;
+}
+
+//Delete all run files
+void ExternalClustering::removeRuns() {
+
+	for (auto &run : runs)
+		remove(run.c_str());
+
+	runs.clear();
+}
+
+/*
+Read the table into runs, merge them down to at most MAX_MERGE_WIDTH
+runs, and apply the merged edges to a union-find.
+*/
+bool ExternalClustering::cluster(const string &fileName, GenomeNetwork &net, int num_clusters,
+	double minHomology) {
+
+	//Read line by line, so only the buffer grows with the table
+	ifstream infile(fileName);
+
+	if (!infile) {
+		cout << "could not read " << fileName << endl;
+		return false;
+	}
+
+	vector<HomologyEdge> buffer;
+
+	string s;
+
+	//skip header
+	getline(infile, s);
+
+	while (getline(infile, s)) {
+
+		//Drop the carriage return of files written on windows
+		if (!s.empty() && s.back() == '\r')
+			s.pop_back();
+
+		string_view gen1;
+		string_view gen2;
+		double homology;
+
+		if (!parseHomologyLine(s.data(), s.data() + s.size(), gen1, gen2, homology))
+			continue;
+
+		//Both genomes are kept even if the edge is dropped, so they still get a family
+		HomologyEdge edge;
+
+		edge.gen1 = net.intern(string(gen1));
+		edge.gen2 = net.intern(string(gen2));
+		edge.homology = homology;
+
+		//genomecompare writes nan for genomes shorter than the sequence length
+		if (homology < minHomology || isnan(homology))
+			continue;
+
+		//Grow the buffer without going past the limit
+		if (buffer.size() == buffer.capacity())
+			buffer.reserve(min(bufferEdges, max((size_t)1024, 2 * buffer.capacity())));
+
+		buffer.push_back(edge);
+		++numEdges;
+
+		if (buffer.size() == bufferEdges && !writeRun(buffer))
+			return false;
+	}
+
+	if (!buffer.empty() && !writeRun(buffer))
+		return false;
+
+	vector<HomologyEdge>().swap(buffer);
+
+	if (num_clusters < 1) {
+		cout << "number of clusters must be given!" << endl;
+		return false;
+	}
+
+	if (num_clusters > net.numNodes()) {
+		cout << "number of clusters must be smaller than number of nodes!" << endl;
+		return false;
+	}
+
+	cout << numEdges << " edges sorted into " << runs.size() << " runs" << endl;
+
+	//Merge groups of consecutive runs until they can all be merged at once
+	while (runs.size() > MAX_MERGE_WIDTH) {
+
+		vector<string> merged;
+
+		for (size_t first = 0; first < runs.size(); first += MAX_MERGE_WIDTH) {
+
+			size_t last = min(runs.size(), first + MAX_MERGE_WIDTH);
+
+			string runName = runPrefix + "m" + to_string(merged.size()) + "_" + to_string(runs.size());
+
+			ofstream out(runName, ios::binary);
+
+			bool read = mergeRuns(first, last, [&](const HomologyEdge &edge) {
+				out.write((const char *)&edge, sizeof(HomologyEdge));
+				return true;
+			});
+
+			merged.push_back(runName);
+
+			//Keep the partial runs with the others, so they are all removed
+			if (!read || !out) {
+				if (read)
+					cout << "could not write " << runName << endl;
+				runs.insert(runs.end(), merged.begin(), merged.end());
+				return false;
+			}
+		}
+
+		removeRuns();
+		runs.swap(merged);
+	}
+
+	//Every genome starts as its own family
+	unsigned int n = net.numNodes();
+
+	vector<unsigned int> parent(n);
+	iota(parent.begin(), parent.end(), 0);
+
+	auto find = [&](unsigned int node) {
+
+		while (parent[node] != node) {
+			parent[node] = parent[parent[node]];
+			node = parent[node];
+		}
+
+		return node;
+	};
+
+	unsigned int families = n;
+
+	//Join families from the most homologous edge down until one more join would leave too few
+	bool merged = mergeRuns(0, runs.size(), [&](const HomologyEdge &edge) {
+
+		unsigned int root1 = find(edge.gen1);
+		unsigned int root2 = find(edge.gen2);
+
+		if (root1 == root2)
+			return true;
+
+		if (families - 1 < (unsigned int)num_clusters)
+			return false;
+
+		parent[max(root1, root2)] = min(root1, root2);
+
+		--families;
+		++appliedEdges;
+
+		return true;
+	});
+
+	removeRuns();
+
+	if (!merged)
+		return false;
+
+	vector<unsigned int> labels(n);
+
+	for (unsigned int i = 0; i < n; ++i)
+		labels[i] = find(i);
+
+	net.setFamilies(labels);
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+/*
+Armon Azizi
+
+ExternalClustering.h
+
+This class clusters a homology table with single linkage, like
+GenomeNetwork::cluster, without holding its edges in memory.
+
+The table is read once. Genome names are interned into the network as
+usual, but edges are collected in a buffer of a fixed size. Whenever the
+buffer is full it is sorted by decreasing homology and written to a run
+file on disk. The runs are then merged, so the edges come back one at a
+time from the most to the least homologous.
+
+Every genome starts as its own family, and the merged edges are fed to
+a union-find over the genome ids. An edge that joins two families is
+applied, unless it would leave fewer families than requested, at which
+point all remaining edges are the ones GenomeNetwork::cluster trims.
+Only the union-find, one id per genome, and one buffered record per run
+are in memory while merging, so the size of the table is limited by the
+disk instead of memory.
+
+Edges are ordered exactly like the sorted edge array of GenomeNetwork,
+with homologies rounded to float and equal homologies in reverse input
+order, so the families are the same as GenomeNetwork::cluster finds.
+*/
+
+#ifndef EXTERNALCLUSTERING_H
+#define EXTERNALCLUSTERING_H
+
+#include "GenomeNetwork.h"
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class ExternalClustering {
+
+private:
+	//Number of edges sorted in memory at once
+	size_t bufferEdges;
+
+	//Run files are named runPrefix followed by a number
+	string runPrefix;
+
+	//Names of the run files written so far
+	vector<string> runs;
+
+	//Sort the buffer and write it to a new run file
+	bool writeRun(vector<HomologyEdge> &buffer);
+
+	/*
+	Merge runs first to last - 1 in order of decreasing homology, calling
+	onEdge for every edge until it returns false.
+	*/
+	template<typename EdgeFn>
+	bool mergeRuns(size_t first, size_t last, EdgeFn onEdge);
+
+	//Delete all run files
+	void removeRuns();
+
+public:
+
+	//Edges read from the table, and edges applied to the families
+	size_t numEdges;
+	size_t appliedEdges;
+
+	/*
+	memLimit is the number of bytes of edges sorted in memory at once.
+	runPrefix is the start of the names of the temporary run files.
+	*/
+	ExternalClustering(size_t memLimit, const string &runPrefix);
+
+	~ExternalClustering();
+
+	/*
+	Read the homology table in fileName, intern its genomes into the network
+	and set the network's families to the num_clusters single linkage families.
+	Edges with a homology below minHomology are ignored, but their genomes
+	are still interned, so a genome with only weak edges is a family of its own.
+
+	Return false, after printing why, if the table can't be read, the run
+	files can't be written or the number of clusters doesn't fit the network.
+	*/
+	bool cluster(const string &fileName, GenomeNetwork &net, int num_clusters, double minHomology);
+};
+
+
+#endif // EXTERNALCLUSTERING_H
\ No newline at end of file
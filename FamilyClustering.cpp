@@ -0,0 +1,189 @@
+/*
+Armon Azizi
+
+FamilyClustering.cpp
+
+The clustering half of the pipeline, shared by findfamilies and
+clusterpipeline: the clustering options, running the chosen
+clustering method on a GenomeNetwork, and writing the families.
+*/
+
+#include "FamilyClustering.h"
+#include "GenomeNetwork.h"
+#include "MarkovClustering.h"
+#include "AverageLinkage.h"
+#include "Parallel.h"
+
+#include <string>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+
+using namespace std;
+
+ClusterOptions::ClusterOptions() {
+	method = "single";
+	numClusters = 0;
+	inflation = 2.0;
+	neighbors = 20;
+	numThreads = defaultThreads();
+}
+
+//Read a clustering option from the command line
+bool parseClusterOption(int argc, char** argv, int &i, ClusterOptions &options) {
+
+	bool hasValue = i + 1 < argc;
+
+	if (!strcmp(argv[i], "--method") && hasValue)
+		options.method = argv[++i];
+	else if (!strcmp(argv[i], "--inflation") && hasValue)
+		options.inflation = atof(argv[++i]);
+	else if (!strcmp(argv[i], "--neighbors") && hasValue)
+		options.neighbors = atoi(argv[++i]);
+	else if (!strcmp(argv[i], "--threads") && hasValue)
+		options.numThreads = atoi(argv[++i]);
+	else
+		return false;
+
+	return true;
+}
+
+//Print the usage of the clustering options
+void printClusterOptions() {
+	cout << "  --method single|average|mcl  clustering method (default: single)" << endl;
+	cout << "  --inflation R                MCL inflation power (default: 2.0)" << endl;
+	cout << "  --neighbors K                MCL edges per genome (default: 20)" << endl;
+	cout << "  --threads N                  number of threads (default: number of cores)" << endl;
+}
+
+//Check the options that don't depend on the network
+bool checkClusterOptions(const ClusterOptions &options) {
+
+	if (options.method != "single" && options.method != "average" && options.method != "mcl") {
+		cout << "unknown clustering method " << options.method << endl;
+		return false;
+	}
+
+	//An inflation of 1 or less never sharpens the flow, and below 0 it turns into nan
+	if (!(options.inflation > 1)) {
+		cout << "inflation must be above 1" << endl;
+		return false;
+	}
+
+	if (options.neighbors < 1) {
+		cout << "number of neighbors must be at least 1" << endl;
+		return false;
+	}
+
+	return true;
+}
+
+//Cluster the network with the method in options
+bool findFamilies(GenomeNetwork &net, ClusterOptions &options) {
+
+	if (!checkClusterOptions(options))
+		return false;
+
+	if (options.method != "mcl" && options.numClusters < 1) {
+		cout << "number of clusters must be given!" << endl;
+		return false;
+	}
+
+	if (options.numClusters > net.numNodes()) {
+		cout << "number of clusters must be smaller than number of nodes!" << endl;
+		return false;
+	}
+
+	net.setThreads(options.numThreads);
+
+	cout << "Finding families" << endl;
+
+	if (options.method == "mcl") {
+
+		//Let the flow decide the families
+		MarkovClustering mcl(options.inflation, options.numThreads);
+
+		mcl.maxNeighbors = options.neighbors;
+
+		net.setFamilies(mcl.cluster(net));
+
+		if (mcl.converged)
+			cout << "MCL converged after " << mcl.iterations << " iterations" << endl;
+		else
+			cout << "MCL did not converge, stopped after " << mcl.iterations << " iterations" << endl;
+	}
+	else if (options.method == "average") {
+
+		//Join whole families by their average homology
+		AverageLinkage upgma;
+
+		net.setFamilies(upgma.cluster(net, options.numClusters));
+	}
+	else {
+
+		//Find num_clusters families in the network
+		net.cluster(options.numClusters);
+	}
+
+	return true;
+}
+
+//Write all families to the output file
+void writeFile(string outFile, vector<pair<string, vector<string>>> families) {
+
+	ofstream out(outFile);
+
+	for (auto i : families) {
+
+		//Write family name
+		out << i.first << endl;
+		out.flush();
+
+		//Write all species in the family
+		for (auto j : i.second) {
+			out << j << endl;
+			out.flush();
+		}
+
+		out << endl;
+		out.flush();
+
+	}
+
+	out.close();
+}
+
+/*
+Read families written by writeFile.
+
+Each family is its name, then one genome per line, then a blank line.
+*/
+vector<pair<string, vector<string>>> readFamilies(string inFile) {
+
+	vector<pair<string, vector<string>>> families;
+
+	ifstream in(inFile);
+
+	string line;
+
+	bool inFamily = false;
+
+	while (getline(in, line)) {
+
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+
+		if (line == "") {
+			inFamily = false;
+		}
+		else if (!inFamily) {
+			families.push_back(make_pair(line, vector<string>()));
+			inFamily = true;
+		}
+		else {
+			families.back().second.push_back(line);
+		}
+	}
+
+	return families;
+}
\ No newline at end of file
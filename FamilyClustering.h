@@ -0,0 +1,72 @@
+/*
+Armon Azizi
+
+FamilyClustering.h
+
+The clustering half of the pipeline, shared by findfamilies and
+clusterpipeline: the clustering options, running the chosen
+clustering method on a GenomeNetwork, and writing the families.
+*/
+
+#ifndef FAMILYCLUSTERING_H
+#define FAMILYCLUSTERING_H
+
+#include "GenomeNetwork.h"
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//Options that control how the network is clustered
+struct ClusterOptions {
+
+	//single, average or mcl
+	string method;
+
+	//Number of families, not used by mcl
+	int numClusters;
+
+	//MCL inflation power
+	double inflation;
+
+	//Number of strongest edges of every genome used by MCL
+	int neighbors;
+
+	//Number of threads
+	int numThreads;
+
+	ClusterOptions();
+};
+
+/*
+If argv[i] is a clustering option, read it (and its value) into options,
+advance i past it and return true. Otherwise return false.
+*/
+bool parseClusterOption(int argc, char** argv, int &i, ClusterOptions &options);
+
+//Print the usage of the clustering options
+void printClusterOptions();
+
+/*
+Check the options that don't depend on the network, such as the method
+and the MCL parameters. Return false, after printing why, if one is out
+of range, so a program can stop before reading its input.
+*/
+bool checkClusterOptions(const ClusterOptions &options);
+
+/*
+Cluster the network into families with the method in options.
+
+Return false, after printing why, if the options don't work for this network.
+*/
+bool findFamilies(GenomeNetwork &net, ClusterOptions &options);
+
+//Write all families to the output file
+void writeFile(string outFile, vector<pair<string, vector<string>>> families);
+
+//Read families written by writeFile. Return an empty vector if the file can't be read.
+vector<pair<string, vector<string>>> readFamilies(string inFile);
+
+
+#endif // FAMILYCLUSTERING_H
\ No newline at end of file
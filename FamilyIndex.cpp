@@ -0,0 +1,247 @@
+/*
+Armon Azizi
+
+FamilyIndex.cpp
+
+A merged index of the sequences of every family, used to classify
+a new genome without comparing it to every genome one at a time.
+*/
+
+#include "FamilyIndex.h"
+#include "KmerScanner.h"
+#include "Parallel.h"
+
+#include <string>
+#include <vector>
+#include <queue>
+#include <functional>
+#include <algorithm>
+
+using namespace std;
+
+FamilyIndex::FamilyIndex(int seqLen, int numThreads)
+	: seqLen(seqLen), numThreads(numThreads), slotMask(0) {}
+
+//Read the distinct sequences of a genome, sorted. Return false if the file can't be read.
+static bool readGenomeSequences(const string &fileName, int seqLen, vector<uint64_t> &codes) {
+
+	codes.clear();
+
+	bool read = dispatchLength(seqLen, [&](auto length) {
+		return scanSequences(fileName, length, FixedLength<1>(), [&](uint64_t code, bool valid) {
+			if (valid) codes.push_back(code);
+		});
+	});
+
+	sort(codes.begin(), codes.end());
+	codes.erase(unique(codes.begin(), codes.end()), codes.end());
+
+	return read;
+}
+
+//Add the sorted sequences of one member to the sorted member counts of its family
+static void addMember(vector<pair<uint64_t, unsigned int>> &counts, const vector<uint64_t> &codes) {
+
+	vector<pair<uint64_t, unsigned int>> merged;
+	merged.reserve(counts.size() + codes.size());
+
+	size_t i = 0, j = 0;
+
+	while (i < counts.size() || j < codes.size()) {
+
+		if (j == codes.size() || (i < counts.size() && counts[i].first < codes[j])) {
+			merged.push_back(counts[i++]);
+		}
+		else if (i == counts.size() || codes[j] < counts[i].first) {
+			merged.push_back(make_pair(codes[j++], 1));
+		}
+		else {
+			merged.push_back(make_pair(counts[i].first, counts[i].second + 1));
+			++i;
+			++j;
+		}
+	}
+
+	counts.swap(merged);
+}
+
+bool FamilyIndex::build(const vector<pair<string, vector<string>>> &families, string &unreadable) {
+
+	unsigned int n = families.size();
+
+	familyNames.clear();
+	familySizes.clear();
+
+	for (auto &family : families) {
+		familyNames.push_back(family.first);
+		familySizes.push_back(family.second.size());
+	}
+
+	//Count the members containing every sequence of each family, one family per task
+	vector<vector<pair<uint64_t, unsigned int>>> counts(n);
+	vector<string> failed(n);
+
+	parallelFor(n, 1, numThreads, [&](size_t begin, size_t end, int) {
+
+		vector<uint64_t> codes;
+
+		for (size_t f = begin; f < end; ++f) {
+			for (auto &genome : families[f].second) {
+
+				if (!readGenomeSequences(genome, seqLen, codes)) {
+					failed[f] = genome;
+					break;
+				}
+
+				addMember(counts[f], codes);
+			}
+		}
+	});
+
+	for (unsigned int f = 0; f < n; ++f) {
+		if (failed[f] != "") {
+			unreadable = failed[f];
+			return false;
+		}
+	}
+
+	//Merge the families in order of sequence, so the postings of a sequence are contiguous
+	size_t total = 0;
+
+	for (auto &familyCounts : counts)
+		total += familyCounts.size();
+
+	postings.clear();
+	postings.reserve(total);
+	postingStart.clear();
+
+	vector<uint64_t> entryCodes;
+
+	typedef pair<uint64_t, unsigned int> HeapItem;
+
+	priority_queue<HeapItem, vector<HeapItem>, greater<HeapItem>> heap;
+	vector<size_t> next(n, 0);
+
+	for (unsigned int f = 0; f < n; ++f)
+		if (!counts[f].empty())
+			heap.push(make_pair(counts[f][0].first, f));
+
+	while (!heap.empty()) {
+
+		uint64_t code = heap.top().first;
+		unsigned int f = heap.top().second;
+
+		heap.pop();
+
+		if (entryCodes.empty() || entryCodes.back() != code) {
+			entryCodes.push_back(code);
+			postingStart.push_back(postings.size());
+		}
+
+		postings.push_back(Posting{f, counts[f][next[f]].second});
+
+		if (++next[f] < counts[f].size())
+			heap.push(make_pair(counts[f][next[f]].first, f));
+		else
+			vector<pair<uint64_t, unsigned int>>().swap(counts[f]);
+	}
+
+	postingStart.push_back(postings.size());
+
+	//Hash table at most half full
+	uint64_t capacity = 2;
+
+	while (capacity < 2 * entryCodes.size())
+		capacity <<= 1;
+
+	slotMask = capacity - 1;
+	slotCodes.assign(capacity, 0);
+	slotEntries.assign(capacity, NO_ENTRY);
+
+	for (size_t e = 0; e < entryCodes.size(); ++e) {
+
+		uint64_t slot = hashSequence(entryCodes[e]) & slotMask;
+
+		while (slotEntries[slot] != NO_ENTRY)
+			slot = (slot + 1) & slotMask;
+
+		slotCodes[slot] = entryCodes[e];
+		slotEntries[slot] = e;
+	}
+
+	return true;
+}
+
+size_t FamilyIndex::find(uint64_t code) {
+
+	uint64_t slot = hashSequence(code) & slotMask;
+
+	while (slotEntries[slot] != NO_ENTRY) {
+
+		if (slotCodes[slot] == code)
+			return slotEntries[slot];
+
+		slot = (slot + 1) & slotMask;
+	}
+
+	return NO_ENTRY;
+}
+
+int FamilyIndex::classify(const string &queryFile, vector<double> &containment, vector<double> &support) {
+
+	unsigned int n = numFamilies();
+
+	vector<size_t> hits(n, 0);
+	vector<double> memberHits(n, 0);
+
+	//Share of a family's members that one member tag stands for
+	vector<double> memberShare(n, 0);
+
+	for (unsigned int f = 0; f < n; ++f)
+		if (familySizes[f] > 0)
+			memberShare[f] = 1.0 / familySizes[f];
+
+	size_t total = 0;
+
+	auto onSequence = [&](uint64_t code, bool valid) {
+
+		++total;
+
+		if (!valid || slotEntries.empty()) return;
+
+		size_t entry = find(code);
+
+		if (entry == NO_ENTRY) return;
+
+		for (size_t p = postingStart[entry]; p < postingStart[entry + 1]; ++p) {
+			++hits[postings[p].family];
+			memberHits[postings[p].family] += postings[p].members * memberShare[postings[p].family];
+		}
+	};
+
+	bool read = dispatchLength(seqLen, [&](auto length) {
+		return scanSequences(queryFile, length, length, onSequence);
+	});
+
+	if (!read)
+		return -1;
+
+	containment.assign(n, 0);
+	support.assign(n, 0);
+
+	int best = -1;
+
+	for (unsigned int f = 0; f < n; ++f) {
+
+		if (total > 0) {
+			containment[f] = (double)hits[f] / total;
+			support[f] = memberHits[f] / total;
+		}
+
+		if (best == -1 || containment[f] > containment[best]
+			|| (containment[f] == containment[best] && support[f] > support[best]))
+			best = f;
+	}
+
+	return best;
+}
\ No newline at end of file
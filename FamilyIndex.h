@@ -0,0 +1,98 @@
+/*
+Armon Azizi
+
+FamilyIndex.h
+
+A merged index of the sequences of every family, used to classify
+a new genome without comparing it to every genome one at a time.
+
+For every family the sequences of all of its members are merged, and
+each sequence is tagged with the number of members it appears in. The
+families are then merged into one hash table, so each sequence of a new
+genome is looked up once and the lookup returns every family that
+contains it.
+
+Sequences are stored as 2 bit packed integers, so sequence lengths of
+up to 32 are supported.
+*/
+
+#ifndef FAMILYINDEX_H
+#define FAMILYINDEX_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+class FamilyIndex {
+
+public:
+
+	FamilyIndex(int seqLen, int numThreads);
+
+	/*
+	Build the index from families in the format findfamilies writes, where
+	every genome is the path of its fasta file.
+
+	Return false if a genome could not be read, and set unreadable to its path.
+	*/
+	bool build(const vector<pair<string, vector<string>>> &families, string &unreadable);
+
+	/*
+	Read the query genome once and look up each of its sequences, the
+	sequences getMappedPercentage would search for.
+
+	containment[f] is the proportion of the query's sequences found in
+	family f. support[f] is the proportion of the query's sequences found
+	in an average member of family f, counted from the member tags.
+
+	Return the family with the highest containment, ties going to the
+	higher support, or -1 if the query could not be read or there
+	are no families.
+	*/
+	int classify(const string &queryFile, vector<double> &containment, vector<double> &support);
+
+	unsigned int numFamilies() { return familyNames.size(); }
+
+	const string &getFamilyName(unsigned int family) { return familyNames[family]; }
+
+	unsigned int getFamilySize(unsigned int family) { return familySizes[family]; }
+
+	//Number of distinct sequences in all families
+	size_t numSequences() { return postingStart.empty() ? 0 : postingStart.size() - 1; }
+
+private:
+
+	//A family that contains a sequence and the number of its members that do
+	struct Posting {
+		unsigned int family;
+		unsigned int members;
+	};
+
+	//Return the entry of a sequence in the hash table, or NO_ENTRY
+	size_t find(uint64_t code);
+
+	//Entries are numbered with size_t, since merged families can hold more than 2^32 sequences
+	static constexpr size_t NO_ENTRY = SIZE_MAX;
+
+	int seqLen;
+
+	int numThreads;
+
+	vector<string> familyNames;
+
+	vector<unsigned int> familySizes;
+
+	//Open addressing hash table from a sequence to its entry
+	vector<uint64_t> slotCodes;
+	vector<size_t> slotEntries;
+	uint64_t slotMask;
+
+	//The postings of entry e are postings[postingStart[e]] to postings[postingStart[e + 1] - 1]
+	vector<size_t> postingStart;
+	vector<Posting> postings;
+};
+
+
+#endif // FAMILYINDEX_H
\ No newline at end of file
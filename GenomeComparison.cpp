@@ -0,0 +1,840 @@
+/*
+Armon Azizi
+
+GenomeComparison.cpp
+
+The comparison half of the pipeline, shared by genomecompare and
+clusterpipeline.
+
+For each genome a multiway trie of all of its sequences of a given
+length is built, and every other genome is split into sequences of
+that length which are searched for in the trie. The proportion of
+sequences found is the homology of the second genome to the first.
+*/
+
+#include "GenomeComparison.h"
+#include "GenomeTrie.h"
+#include "KmerIndex.h"
+#include "KmerScanner.h"
+#include "ContainmentSampler.h"
+#include "Parallel.h"
+#include "PerfCounters.h"
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <cstdint>
+#include <memory>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+//Number of sequences getMappedCounts searches for at once
+const size_t LOOKUP_BATCH = 4096;
+
+/*
+given a path to a fasta file containing a genome, build a 
+GenomeTrie that contains all of its sequences. The trie will only
+contain sequences of length seqLen.
+*/
+void buildTrie(string fileName, GenomeTrie &trie, int seqLen) {
+
+	//Read fasta file
+	ifstream infile(fileName);
+	
+	string tempSequence = "";
+
+	//read file line by line, and parse in into the correct length sequences.
+	while (infile) {
+
+		string s;
+
+		// get the next line
+		if (!getline(infile, s)) break;
+		
+		//skip fasta header lines
+		if (s[0] == '>') continue;
+
+		//Add current sequence to temp
+		tempSequence += s;
+
+		//If the temp is shorter than the length we want, read another line.
+		if (tempSequence.size() < seqLen) continue;
+
+		//While the temp is longer than the sequence we want,
+		//remove sequence from front of temp and add it to the trie.
+		while (tempSequence.size() > seqLen) {
+			
+			string newSeq = tempSequence.substr(0, seqLen);
+			
+			trie.addSequence(newSeq);
+			
+			tempSequence = tempSequence.substr(1);
+		}
+
+	}
+
+	infile.close();
+
+}
+
+/*
+Given a built genometrie and a path to a fasta file of the genome
+that we want to map to the trie, return the proportion of mapped reads
+contained in the genome of the given length.
+*/
+double getMappedPercentage(string fileName, GenomeTrie &trie, int seqLen) {
+
+	size_t numMappedReads, totalReads;
+
+	getMappedCounts(fileName, trie, seqLen, numMappedReads, totalReads);
+
+	//return the number of mapped reads over the number of reads searched for in the trie.
+	return (double)numMappedReads / (double)totalReads;
+}
+
+/*
+Count the reads of the genome of the given length that are mapped
+to the trie, and the total number of reads searched for.
+*/
+void getMappedCounts(string fileName, GenomeTrie &trie, int seqLen, size_t &mapped, size_t &total) {
+
+	size_t numMappedReads = 0;
+	size_t totalReads = 0;
+
+
+	ifstream infile(fileName);
+
+	string tempSequence = "";
+
+	//Sequences are searched for in batches, so their lookups can overlap
+	string batch = "";
+	size_t batchCount = 0;
+
+	//Read file line by line.
+	while (infile) {
+
+		string s;
+
+		// get the next line
+		if (!getline(infile, s)) break;
+
+
+		//skip fasta header lines
+		if (s[0] == '>') continue;
+
+
+		tempSequence += s;
+
+		if (tempSequence.size() < seqLen) continue;
+
+		//Read next sequence and add it to the batch to search for in the trie.
+		while (tempSequence.size() > seqLen) {
+
+			batch.append(tempSequence, 0, seqLen);
+
+			if (++batchCount == LOOKUP_BATCH) {
+				numMappedReads += trie.countContained(batch.data(), batchCount, seqLen);
+				batch.clear();
+				batchCount = 0;
+			}
+
+			++totalReads;
+
+			tempSequence = tempSequence.substr(seqLen);
+
+		}
+
+	}
+
+	infile.close();
+
+	numMappedReads += trie.countContained(batch.data(), batchCount, seqLen);
+
+	mapped = numMappedReads;
+	total = totalReads;
+}
+
+/*
+Return all of the sequences that getMappedPercentage searches for
+in the genome, one after another. Each one is seqLen characters long.
+*/
+string getQuerySequences(string fileName, int seqLen) {
+
+	string sequences = "";
+
+	ifstream infile(fileName);
+
+	string tempSequence = "";
+
+	//Read file line by line.
+	while (infile) {
+
+		string s;
+
+		// get the next line
+		if (!getline(infile, s)) break;
+
+		//skip fasta header lines
+		if (s[0] == '>') continue;
+
+		tempSequence += s;
+
+		if (tempSequence.size() < seqLen) continue;
+
+		//Cut the same sequences getMappedPercentage would search for
+		while (tempSequence.size() > seqLen) {
+
+			sequences.append(tempSequence, 0, seqLen);
+
+			tempSequence = tempSequence.substr(seqLen);
+		}
+
+	}
+
+	infile.close();
+
+	return sequences;
+}
+
+/*
+Given a built genometrie and the sequences returned by getQuerySequences,
+return the proportion of sequences contained in the trie.
+*/
+double getMappedProportion(const string &sequences, GenomeTrie &trie, int seqLen) {
+
+	double totalReads = sequences.size() / seqLen;
+
+	double numMappedReads = trie.countContained(sequences.data(), sequences.size() / seqLen, seqLen);
+
+	return (double)(numMappedReads / totalReads);
+}
+
+/*
+Given a path to the directory that all of the files are stored in and the
+titla of a file that contains all of the fasta file titles,
+return a vector of strings that contains the path to each fasta file.
+*/
+vector<string> getFileNames(string genome_directory, string file_names) {
+	
+	vector <string> result;
+
+	ifstream infile(file_names);
+
+	//Read title file line by line
+	while (infile) {
+
+		string s;
+
+		// get the next line
+		if (!getline(infile, s)) break;
+
+		//Strip newline character from file title
+		//s.erase(s.find_last_not_of("\n") + 1);
+		s.pop_back();
+
+		if (s == "") break;
+
+		//new complete path to file.
+		string newName = genome_directory + '/' + s;
+
+		result.push_back(newName);
+	}
+
+	return result;
+}
+
+CompareOptions::CompareOptions() {
+	memLimit = 0;
+	tolerance = 0;
+	seed = 1;
+	minHomology = 0;
+	topK = 0;
+	numThreads = defaultThreads();
+	perf = false;
+}
+
+//Read a number above 0. Return false if the text isn't one.
+static bool parsePositive(const char * text, double &value) {
+
+	char * end;
+
+	double number = strtod(text, &end);
+
+	if (end == text || *end != 0 || !(number > 0))
+		return false;
+
+	value = number;
+
+	return true;
+}
+
+//Read a comparison option from the command line
+bool parseCompareOption(int argc, char** argv, int &i, CompareOptions &options) {
+
+	bool hasValue = i + 1 < argc;
+
+	if (!strcmp(argv[i], "--mem-limit") && hasValue && parseMemorySize(argv[i + 1], options.memLimit))
+		++i;
+	else if (!strcmp(argv[i], "--tolerance") && hasValue && parsePositive(argv[i + 1], options.tolerance))
+		++i;
+	else if (!strcmp(argv[i], "--seed") && hasValue)
+		options.seed = strtoull(argv[++i], nullptr, 10);
+	else if (!strcmp(argv[i], "--min-homology") && hasValue)
+		options.minHomology = atof(argv[++i]);
+	else if (!strcmp(argv[i], "--top-k") && hasValue)
+		options.topK = atoi(argv[++i]);
+	else if (!strcmp(argv[i], "--perf"))
+		options.perf = true;
+	else
+		return false;
+
+	return true;
+}
+
+//Print the usage of the comparison options
+void printCompareOptions() {
+	cout << "  --mem-limit SIZE             memory for genome indexes, such as 16G" << endl;
+	cout << "  --tolerance T                sample until homologies are within T percent (default: 0, exact)" << endl;
+	cout << "  --seed S                     seed of the sampling order (default: 1)" << endl;
+	cout << "  --min-homology H             only keep pairs with at least H percent homology" << endl;
+	cout << "  --top-k K                    only keep each genome's K most homologous pairs" << endl;
+	cout << "  --perf                       report hardware performance counters of every phase" << endl;
+}
+
+/*
+Compare every genome to every other genome for a single sequence length.
+*/
+void compareGenomes(const vector<string> &files, int seqLen, const CompareOptions &options,
+	const PairCallback &onPair) {
+
+	compareGenomes(files, vector<int>(1, seqLen), options,
+		[&](unsigned int, unsigned int i, unsigned int j, double percent, double precision) {
+			onPair(i, j, percent, precision);
+		});
+}
+
+/*
+Return the order the genomes are read in while the indexes of genomes
+first to last - 1 are in memory.
+
+The order goes forward in even blocks and backward in odd blocks, so the
+genomes read last in one block are read first in the next, while they
+are still in the page cache. The genomes of the block itself are always
+read from last to first, so for a pair within the block the direction
+mapped onto the first genome's index is known before the other one.
+*/
+static vector<unsigned int> queryOrder(unsigned int block, unsigned int first, unsigned int last,
+	unsigned int numFiles) {
+
+	vector<unsigned int> order;
+
+	if (block % 2 == 0) {
+		for (unsigned int j = 0; j < first; ++j) order.push_back(j);
+		for (unsigned int j = last; j > first; --j) order.push_back(j - 1);
+		for (unsigned int j = last; j < numFiles; ++j) order.push_back(j);
+	}
+	else {
+		for (unsigned int j = numFiles; j > last; --j) order.push_back(j - 1);
+		for (unsigned int j = last; j > first; --j) order.push_back(j - 1);
+		for (unsigned int j = first; j > 0; --j) order.push_back(j - 1);
+	}
+
+	return order;
+}
+
+/*
+Keeps the K most homologous pairs of every genome while the genomes are
+compared, in a bounded heap per genome and sequence length. The heap
+holds the weakest of the kept pairs on top, so a new pair only has to
+beat that one to get in.
+*/
+class NeighborHeaps {
+
+public:
+
+	NeighborHeaps(unsigned int numLengths, unsigned int numFiles, unsigned int k)
+		: heaps(numLengths, vector<vector<Neighbor>>(numFiles)), k(k) {}
+
+	//Offer a finished pair to the heaps of both of its genomes
+	void add(unsigned int l, unsigned int i, unsigned int j, double percent, double precision) {
+		offer(heaps[l][i], Neighbor{percent, precision, i, j});
+		offer(heaps[l][j], Neighbor{percent, precision, i, j});
+	}
+
+	//Pass on every pair kept by either of its genomes, once, in order of the second genome
+	void emit(const MultiPairCallback &onPair) {
+
+		for (unsigned int l = 0; l < heaps.size(); ++l) {
+
+			vector<Neighbor> kept;
+
+			for (auto &heap : heaps[l])
+				kept.insert(kept.end(), heap.begin(), heap.end());
+
+			sort(kept.begin(), kept.end(), [](const Neighbor &a, const Neighbor &b) {
+				return a.j != b.j ? a.j < b.j : a.i < b.i;
+			});
+
+			for (size_t n = 0; n < kept.size(); ++n)
+				if (n == 0 || kept[n].i != kept[n - 1].i || kept[n].j != kept[n - 1].j)
+					onPair(l, kept[n].i, kept[n].j, kept[n].percent, kept[n].precision);
+
+			vector<vector<Neighbor>>().swap(heaps[l]);
+		}
+	}
+
+private:
+
+	struct Neighbor {
+		double percent;
+		double precision;
+		unsigned int i;
+		unsigned int j;
+	};
+
+	//True if a is a stronger pair than b, ties go to the earlier pair so the result doesn't depend on order
+	static bool stronger(const Neighbor &a, const Neighbor &b) {
+		if (a.percent != b.percent)
+			return a.percent > b.percent;
+		return a.j != b.j ? a.j < b.j : a.i < b.i;
+	}
+
+	void offer(vector<Neighbor> &heap, const Neighbor &pair) {
+
+		if (heap.size() < k) {
+			heap.push_back(pair);
+			push_heap(heap.begin(), heap.end(), stronger);
+		}
+		else if (stronger(pair, heap.front())) {
+			pop_heap(heap.begin(), heap.end(), stronger);
+			heap.back() = pair;
+			push_heap(heap.begin(), heap.end(), stronger);
+		}
+	}
+
+	//heaps[l][i] holds the strongest pairs of genome i for length l
+	vector<vector<vector<Neighbor>>> heaps;
+
+	unsigned int k;
+};
+
+/*
+Compare every genome to every other genome for every sequence length.
+
+First every genome is read once to estimate its distinct sequences with
+HyperLogLog, which chooses the layout of its indexes and how much memory
+they will take. The genomes are then cut into blocks of consecutive
+genomes whose indexes fit in memLimit together. For each block, the
+indexes of its genomes are built, and every genome is read once and
+mapped onto all of them, giving the proportion of genome j found in
+each genome i of the block. With more than one length, each read serves
+all lengths at once.
+
+A pair is finished once both of its genomes have been mapped onto the
+other's index. Until then, the number of reads of the second genome
+mapped to the first genome's index is kept as a 64 bit count in the
+second genome's row, since a genome of many gigabases can have more than
+2^32 reads at a short length. The number of reads searched for only
+depends on the genome, so the count gives back the exact proportion.
+Row j only holds the counts from indexes 0 to j - 1 and is freed as soon
+as the block of genome j is done, so at most about a quarter of an N x N
+matrix of counts is kept at any time.
+
+With a tolerance, each genome's sequences are loaded into a sampler
+instead, and only as many of them are searched for in each index as it
+takes to know the proportion to within the tolerance. The number
+searched for then differs between indexes, so it is kept in a second
+row next to the counts.
+
+Finished pairs below the minimum homology are dropped. With a top K,
+the remaining pairs go into NeighborHeaps and are passed on once all
+genomes are compared, so the output grows with N * K instead of N^2.
+*/
+void compareGenomes(const vector<string> &files, const vector<int> &seqLens, const CompareOptions &options,
+	const MultiPairCallback &onPair) {
+
+	unsigned int numFiles = files.size();
+	unsigned int numLengths = seqLens.size();
+
+	bool shared = numLengths > 1;
+	bool sampling = options.tolerance > 0;
+
+	size_t memLimit = options.memLimit;
+
+	unique_ptr<NeighborHeaps> neighbors;
+
+	if (options.topK > 0)
+		neighbors.reset(new NeighborHeaps(numLengths, numFiles, options.topK));
+
+	//Number of pairs passed on
+	size_t keptPairs = 0;
+
+	MultiPairCallback keepPair = [&](unsigned int l, unsigned int i, unsigned int j, double percent, double precision) {
+		++keptPairs;
+		onPair(l, i, j, percent, precision);
+	};
+
+	//Drop pairs below the minimum, and keep back the rest when only the top K are wanted
+	auto finishPair = [&](unsigned int l, unsigned int i, unsigned int j, double percent, double precision) {
+
+		if (options.minHomology > 0 && !(percent >= options.minHomology))
+			return;
+
+		if (neighbors)
+			neighbors->add(l, i, j, percent, precision);
+		else
+			keepPair(l, i, j, percent, precision);
+	};
+
+	//Hardware counters around every phase, only when asked for
+	unique_ptr<PerfCounters> perf;
+
+	if (options.perf)
+		perf.reset(new PerfCounters());
+
+	//Estimate the distinct sequences of every genome and pick the indexes that suit them
+	cout << "Estimating distinct sequences of " << numFiles << " genomes" << endl;
+
+	if (perf) perf->begin("estimate");
+
+	vector<vector<SequenceEstimate>> estimates(numFiles);
+	vector<size_t> indexMemory(numFiles, 0);
+
+	for (unsigned int i = 0; i < numFiles; ++i) {
+
+		if (shared)
+			estimates[i] = estimateSequences(files[i], seqLens);
+		else
+			estimates[i].assign(1, estimateSequences(files[i], seqLens[0]));
+
+		for (unsigned int l = 0; l < numLengths; ++l) {
+			KmerIndex::Layout layout = chooseLayout(seqLens[l], estimates[i][l].distinct);
+			indexMemory[i] += estimateMemory(layout, seqLens[l], estimates[i][l]);
+		}
+	}
+
+	//Cut the genomes into blocks whose indexes fit in memory together
+	vector<unsigned int> blockStart(1, 0);
+	size_t blockMemory = 0;
+
+	for (unsigned int i = 0; i < numFiles; ++i) {
+
+		if (i > blockStart.back() && blockMemory + indexMemory[i] > memLimit) {
+			blockStart.push_back(i);
+			blockMemory = 0;
+		}
+
+		blockMemory += indexMemory[i];
+	}
+
+	blockStart.push_back(numFiles);
+
+	unsigned int numBlocks = blockStart.size() - 1;
+
+	//pending[l][j][i] is the number of reads of genome j mapped to genome i, for i < j
+	vector<vector<vector<uint64_t>>> pending(numLengths, vector<vector<uint64_t>>(numFiles));
+
+	//Number of reads searched for in every genome
+	vector<vector<size_t>> totals(numLengths, vector<size_t>(numFiles, 0));
+
+	//When sampling, pendingDrawn[l][j][i] is the number of reads of genome j searched for in genome i
+	vector<vector<vector<uint64_t>>> pendingDrawn(sampling ? numLengths : 0, vector<vector<uint64_t>>(numFiles));
+
+	ContainmentSampler sampler(options.tolerance / 100, options.seed);
+
+	//Reads searched for, and the number a full comparison searches for
+	size_t lookups = 0;
+	size_t fullLookups = 0;
+
+	//Number of indexes built with every layout, the largest index and the largest block
+	vector<unsigned int> layoutCounts(NUM_LAYOUTS, 0);
+	size_t largestIndex = 0;
+	size_t largestBlock = 0;
+
+	size_t genomeReads = 0;
+
+	for (unsigned int b = 0; b < numBlocks; ++b) {
+
+		unsigned int first = blockStart[b];
+		unsigned int last = blockStart[b + 1];
+
+		//indexes[i - first][l] is the index of genome i for length l
+		vector<vector<unique_ptr<KmerIndex>>> indexes(last - first);
+
+		size_t blockUsage = 0;
+
+		if (perf) perf->begin("build");
+
+		for (unsigned int i = first; i < last; ++i) {
+
+			string file1 = files[i];
+
+			vector<unique_ptr<KmerIndex>> &genomeIndexes = indexes[i - first];
+
+			for (unsigned int l = 0; l < numLengths; ++l) {
+				KmerIndex::Layout layout = chooseLayout(seqLens[l], estimates[i][l].distinct);
+				genomeIndexes.push_back(createIndex(layout, seqLens[l], estimates[i][l]));
+			}
+
+			//Build the indexes for genome i
+			if (shared) {
+				cout << "Building indexes for :" << file1 << ":";
+				for (unsigned int l = 0; l < numLengths; ++l)
+					cout << (l ? ", k=" : " k=") << seqLens[l] << " " << layoutName(genomeIndexes[l]->layout())
+						<< " (about " << (size_t)estimates[i][l].distinct << ")";
+				cout << endl;
+
+				buildIndexes(file1, seqLens, genomeIndexes);
+			}
+			else {
+				cout << "Building " << layoutName(genomeIndexes[0]->layout()) << " index for :" << file1
+					<< " (about " << (size_t)estimates[i][0].distinct << " distinct sequences)" << endl;
+
+				genomeIndexes[0]->build(file1);
+			}
+
+			for (auto &index : genomeIndexes) {
+				++layoutCounts[index->layout()];
+				largestIndex = max(largestIndex, index->memoryUsage());
+				blockUsage += index->memoryUsage();
+			}
+		}
+
+		if (perf) perf->end();
+
+		largestBlock = max(largestBlock, blockUsage);
+
+		if (numBlocks > 1)
+			cout << "Block " << b + 1 << " of " << numBlocks << ": " << last - first << " genomes, "
+				<< blockUsage / (1024 * 1024) << " MB of indexes" << endl;
+
+		vector<vector<size_t>> mapped;
+		vector<vector<size_t>> drawn;
+		vector<size_t> total;
+
+		//Read every genome once and map it onto all indexes of the block
+		for (unsigned int j : queryOrder(b, first, last, numFiles)) {
+
+			//Genomes of the block other than j
+			vector<unsigned int> residents;
+			vector<vector<KmerIndex *>> targets(numLengths);
+
+			for (unsigned int i = first; i < last; ++i) {
+				if (i != j) {
+					residents.push_back(i);
+					for (unsigned int l = 0; l < numLengths; ++l)
+						targets[l].push_back(indexes[i - first][l].get());
+				}
+			}
+
+			if (residents.empty()) continue;
+
+			if (perf) perf->begin("compare");
+
+			if (sampling) {
+
+				sampler.load(files[j], seqLens, j);
+
+				mapped.assign(numLengths, vector<size_t>(residents.size()));
+				drawn.assign(numLengths, vector<size_t>(residents.size()));
+				total.assign(numLengths, 0);
+
+				for (unsigned int l = 0; l < numLengths; ++l) {
+
+					total[l] = sampler.total(l);
+
+					for (unsigned int x = 0; x < residents.size(); ++x)
+						sampler.sample(*targets[l][x], l, mapped[l][x], drawn[l][x]);
+				}
+			}
+			else {
+
+				countMapped(files[j], seqLens, targets, mapped, total, options.numThreads);
+
+				drawn.assign(numLengths, vector<size_t>());
+				for (unsigned int l = 0; l < numLengths; ++l)
+					drawn[l].assign(residents.size(), total[l]);
+			}
+
+			++genomeReads;
+
+			if (perf) {
+
+				PerfReading counts = perf->end();
+
+				if (perf->isOpen())
+					cout << "Counters for " << files[j] << " onto " << residents.size() << " indexes: "
+						<< PerfCounters::describe(counts) << endl;
+			}
+
+			for (unsigned int x = 0; x < residents.size(); ++x) {
+
+				unsigned int i = residents[x];
+
+				//Calculate homology between genome j and genome i
+				cout << "Calculating Homology For: " << files[i] << " " << files[j] << endl;
+
+				for (unsigned int l = 0; l < numLengths; ++l) {
+
+					totals[l][j] = total[l];
+
+					lookups += drawn[l][x];
+					fullLookups += total[l];
+
+					double value = (double)mapped[l][x] / (double)drawn[l][x];
+					cout << value << (l + 1 < numLengths ? " " : "\n");
+
+					double precision = 0;
+
+					if (sampling)
+						precision = ContainmentSampler::halfWidth(mapped[l][x], drawn[l][x], total[l]);
+
+					//Both directions are known for pairs with an earlier genome
+					if (j < i) {
+
+						double forward = (double)pending[l][i][j] / (double)totals[l][i];
+						double forwardPrecision = 0;
+
+						if (sampling) {
+							size_t forwardDrawn = pendingDrawn[l][i][j];
+							forward = (double)pending[l][i][j] / (double)forwardDrawn;
+							forwardPrecision = ContainmentSampler::halfWidth(pending[l][i][j], forwardDrawn, totals[l][i]);
+						}
+
+						finishPair(l, j, i, pairHomology(forward, value), pairHomology(forwardPrecision, precision));
+					}
+					else {
+						pending[l][j].push_back(mapped[l][x]);
+
+						if (sampling)
+							pendingDrawn[l][j].push_back(drawn[l][x]);
+					}
+				}
+			}
+
+			cout.flush();
+		}
+
+		//The rows of the block are finished
+		for (unsigned int i = first; i < last; ++i)
+			for (unsigned int l = 0; l < numLengths; ++l) {
+				vector<uint64_t>().swap(pending[l][i]);
+				if (sampling)
+					vector<uint64_t>().swap(pendingDrawn[l][i]);
+			}
+	}
+
+	if (neighbors) {
+
+		if (perf) perf->begin("top-k");
+
+		neighbors->emit(keepPair);
+
+		if (perf) perf->end();
+	}
+
+	//Run summary
+	cout << "Index layouts:";
+	for (int l = 0; l < NUM_LAYOUTS; ++l)
+		if (layoutCounts[l] > 0)
+			cout << " " << layoutCounts[l] << " " << layoutName((KmerIndex::Layout)l);
+	cout << ", largest index " << largestIndex / 1024 << " KB" << endl;
+
+	cout << numBlocks << " blocks, largest block " << largestBlock / 1024 << " KB, "
+		<< genomeReads << " genome reads for " << (size_t)numFiles * (numFiles > 0 ? numFiles - 1 : 0)
+		<< " comparisons" << endl;
+
+	if (options.minHomology > 0 || neighbors)
+		cout << "Kept " << keptPairs << " of " << (size_t)numLengths * numFiles * (numFiles > 0 ? numFiles - 1 : 0) / 2
+			<< " pairs" << endl;
+
+	if (sampling)
+		cout << "Sampled " << lookups << " of " << fullLookups << " sequences ("
+			<< (fullLookups > 0 ? 100.0 * lookups / fullLookups : 0) << "%)" << endl;
+
+	if (perf) {
+
+		perf->printSummary();
+
+		//Every genome read serves all of the comparisons onto the indexes of its block
+		size_t comparisons = (size_t)numFiles * (numFiles > 0 ? numFiles - 1 : 0);
+
+		if (perf->isOpen() && comparisons > 0)
+			cout << "  per comparison: "
+				<< PerfCounters::describe(PerfCounters::perUnit(perf->total("compare"), comparisons)) << endl;
+	}
+}
+
+//Return the homology percentage of a pair from the proportions mapped in both directions
+double pairHomology(double forward, double backward) {
+	return ((forward + backward) / 2) * 100;
+}
+
+string tableName(const string &out, int seqLen, bool multipleLengths) {
+
+	if (!multipleLengths)
+		return out;
+
+	//The extension starts at the last dot after the last slash
+	size_t slash = out.find_last_of('/');
+	size_t dot = out.find_last_of('.');
+
+	if (dot == string::npos || (slash != string::npos && dot < slash))
+		dot = out.size();
+
+	return out.substr(0, dot) + ".k" + to_string(seqLen) + out.substr(dot);
+}
+
+bool parseMemorySize(const string &text, size_t &bytes) {
+
+	char * end;
+
+	double size = strtod(text.c_str(), &end);
+
+	if (end == text.c_str() || size < 0)
+		return false;
+
+	string suffix = end;
+
+	double unit = 1;
+
+	if (suffix == "K" || suffix == "k") unit = 1024.0;
+	else if (suffix == "M" || suffix == "m") unit = 1024.0 * 1024;
+	else if (suffix == "G" || suffix == "g") unit = 1024.0 * 1024 * 1024;
+	else if (suffix == "T" || suffix == "t") unit = 1024.0 * 1024 * 1024 * 1024;
+	else if (suffix != "") return false;
+
+	bytes = (size_t)(size * unit);
+
+	return true;
+}
+
+HomologyWriter::HomologyWriter(const string &out, const vector<string> &files, bool withPrecision)
+	: outFile(out), files(files), lastGenome(0), withPrecision(withPrecision) {
+
+	//Write Header
+	outFile << "Genome1\tGenome2\tHomology Percent" << (withPrecision ? "\tPrecision" : "") << endl;
+}
+
+void HomologyWriter::write(unsigned int i, unsigned int j, double percent, double precision) {
+
+	if (j != lastGenome) {
+		outFile.flush();
+		lastGenome = j;
+	}
+
+	outFile << files[i] << '\t' << files[j] << '\t' << to_string(percent);
+
+	if (withPrecision)
+		outFile << '\t' << to_string(precision);
+
+	outFile << '\n';
+}
+
+HomologyWriter::~HomologyWriter() {
+	outFile.close();
+}
\ No newline at end of file
@@ -0,0 +1,200 @@
+/*
+Armon Azizi
+
+GenomeComparison.h
+
+The comparison half of the pipeline, shared by genomecompare and
+clusterpipeline.
+
+For each genome a multiway trie of all of its sequences of a given
+length is built, and every other genome is split into sequences of
+that length which are searched for in the trie. The proportion of
+sequences found is the homology of the second genome to the first.
+*/
+
+#ifndef GENOMECOMPARISON_H
+#define GENOMECOMPARISON_H
+
+#include "GenomeTrie.h"
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <functional>
+#include <cstdint>
+
+using namespace std;
+
+/*
+given a path to a fasta file containing a genome, build a
+GenomeTrie that contains all of its sequences. The trie will only
+contain sequences of length seqLen.
+*/
+void buildTrie(string fileName, GenomeTrie &trie, int seqLen);
+
+/*
+Given a built genometrie and a path to a fasta file of the genome
+that we want to map to the trie, return the proportion of mapped reads
+contained in the genome of the given length.
+*/
+double getMappedPercentage(string fileName, GenomeTrie &trie, int seqLen);
+
+/*
+Same as getMappedPercentage, but return the number of mapped reads and
+the number of reads searched for instead of their proportion.
+*/
+void getMappedCounts(string fileName, GenomeTrie &trie, int seqLen, size_t &mapped, size_t &total);
+
+/*
+Return all of the sequences that getMappedPercentage searches for
+in the genome, one after another. Each one is seqLen characters long.
+
+Keeping these in memory lets a genome be compared again later
+without reading its file.
+*/
+string getQuerySequences(string fileName, int seqLen);
+
+/*
+Given a built genometrie and the sequences returned by getQuerySequences,
+return the proportion of sequences contained in the trie.
+This is the same value getMappedPercentage returns for the file.
+*/
+double getMappedProportion(const string &sequences, GenomeTrie &trie, int seqLen);
+
+/*
+Given a path to the directory that all of the files are stored in and the
+titla of a file that contains all of the fasta file titles,
+return a vector of strings that contains the path to each fasta file.
+*/
+vector<string> getFileNames(string genome_directory, string file_names);
+
+//How compareGenomes compares the genomes
+struct CompareOptions {
+
+	/*
+	Number of bytes of indexes that may be kept in memory at once. As many
+	genomes as fit are indexed together, and every other genome is read
+	once for all of them. With a limit of 0 one genome is indexed at a time.
+	*/
+	size_t memLimit;
+
+	/*
+	Homology percentage points each direction of a pair may be off by, at a
+	nominal 95% confidence. With a tolerance above 0 every direction is
+	estimated from a random sample of the genome's sequences with a
+	ContainmentSampler, instead of searching for all of them. 0, the
+	default, searches for all of them. --tolerance only accepts values above 0.
+	*/
+	double tolerance;
+
+	//Seed of the order sequences are sampled in
+	uint64_t seed;
+
+	//Only pairs with at least this homology percentage are passed on, 0 passes all of them
+	double minHomology;
+
+	/*
+	Only pass on the pairs that are among the topK most homologous pairs
+	of either of their genomes, 0 passes all of them. These are only known
+	once every pair is done, so they are all passed on at the end.
+	*/
+	int topK;
+
+	//Number of threads that search the indexes for one genome at a time
+	int numThreads;
+
+	/*
+	Read the hardware performance counters around every phase and every
+	genome read with PerfCounters, and print them with the run summary.
+	*/
+	bool perf;
+
+	CompareOptions();
+};
+
+/*
+If argv[i] is a comparison option, read it (and its value) into options,
+advance i past it and return true. Otherwise return false.
+*/
+bool parseCompareOption(int argc, char** argv, int &i, CompareOptions &options);
+
+//Print the usage of the comparison options
+void printCompareOptions();
+
+/*
+Called with a pair of genomes i < j, their homology percentage and how
+many percentage points it may be off by, which is 0 unless sampled.
+*/
+typedef function<void(unsigned int, unsigned int, double, double)> PairCallback;
+
+/*
+Compare every genome to every other genome.
+
+onPair is called for every pair as soon as the pair is finished,
+so results can be written before all comparisons are done.
+*/
+void compareGenomes(const vector<string> &files, int seqLen, const CompareOptions &options,
+	const PairCallback &onPair);
+
+//Called with the index of a sequence length, then the same values as a PairCallback
+typedef function<void(unsigned int, unsigned int, unsigned int, double, double)> MultiPairCallback;
+
+/*
+Compare every genome to every other genome for several sequence lengths
+at once, all at most 32 when there is more than one or when sampling.
+
+Every genome is read once per pass for all lengths, instead of once
+per length.
+*/
+void compareGenomes(const vector<string> &files, const vector<int> &seqLens, const CompareOptions &options,
+	const MultiPairCallback &onPair);
+
+/*
+Read a memory size such as 512M or 16G (K, M, G and T are powers of 1024,
+no suffix is bytes). Return false if it isn't a size.
+*/
+bool parseMemorySize(const string &text, size_t &bytes);
+
+/*
+Return the name of the table for one of several sequence lengths,
+out_file with .k<seqLen> before its extension. With a single length
+the name is out_file itself.
+*/
+string tableName(const string &out, int seqLen, bool multipleLengths);
+
+//Return the homology percentage of a pair from the proportions mapped in both directions
+double pairHomology(double forward, double backward);
+
+/*
+Writes the homology table, one pair at a time.
+
+The header is written when the file is opened. Lines are flushed
+whenever the second genome of a pair changes, so every finished batch
+of pairs shows up in the file right away.
+
+When the homologies are sampled, a fourth column holds how many
+percentage points each one may be off by.
+*/
+class HomologyWriter {
+
+public:
+
+	HomologyWriter(const string &out, const vector<string> &files, bool withPrecision = false);
+
+	void write(unsigned int i, unsigned int j, double percent, double precision = 0);
+
+	~HomologyWriter();
+
+private:
+
+	ofstream outFile;
+
+	const vector<string> &files;
+
+	unsigned int lastGenome;
+
+	bool withPrecision;
+};
+
+
+#endif // GENOMECOMPARISON_H
\ No newline at end of file
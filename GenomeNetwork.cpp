@@ -6,10 +6,10 @@ GenomeNetwork.cpp
 This class represents a network of genomes
 related by how homologous they are to eachother.
 
-The network is mad up of a set of GenomeNodes, each one represents
-a different species. The nodes are connected to each other through
-pointers with each pointer corresponding to a certain homology,
-or degree of similarity.
+Every genome name is interned to a dense integer id the first time
+it is read, so the rest of the network never hashes or compares strings.
+Homology edges are kept in one contiguous array which is sorted by
+homology and turned into a compressed sparse row (CSR) adjacency.
 
 Using the graph, genomes can be clustered into families based on
 how related they are to each other. The clustering usis achieved using a markov-like
@@ -21,22 +21,44 @@ a number of families predefined by the user.
 */
 
 #include "GenomeNetwork.h"
-#include "GenomeNode.h"
+#include "ConnectedComponents.h"
+#include "Parallel.h"
 
 #include <vector>
-#include <set>
+#include <algorithm>
 #include <iostream>
 
 using namespace std;
 
 GenomeNetwork::GenomeNetwork() {
+	finalized = true;
+	removedEdges = 0;
+	numThreads = defaultThreads();
 }
 
-//Delete all nodes from the graph.
 GenomeNetwork::~GenomeNetwork() {
-	for (auto i : nodes) {
-		delete i.second;
-	}
+}
+
+/*
+Return the id of the given genome.
+
+If the genome is not in the network yet, it is given the next free id.
+*/
+unsigned int GenomeNetwork::intern(const string &genome) {
+
+	auto itr = ids.find(genome);
+
+	if (itr != ids.end())
+		return itr->second;
+
+	unsigned int id = names.size();
+
+	ids.emplace(genome, id);
+	names.push_back(genome);
+
+	finalized = false;
+
+	return id;
 }
 
 /*
@@ -44,108 +66,180 @@ Add a connection between the two specified genomes with the given homology
 
 If the nodes don't already exist in the graph, create them and add connection.
 */
-void GenomeNetwork::addSet(string genome1, string genome2, double homology) {
-
-	GenomeNode * temp1;
-	GenomeNode * temp2;
-	
-	//Check if node exists in graph and if not, add new node.
-	if (hasNode(genome1)) {
-		temp1 = nodes[genome1];
-	}
-	else {
-		temp1 = new GenomeNode(genome1);
+void GenomeNetwork::addSet(const string &genome1, const string &genome2, double homology) {
 
-		nodes[genome1] = temp1;
-	}
+	unsigned int gen1 = intern(genome1);
+	unsigned int gen2 = intern(genome2);
 
-	if (hasNode(genome2)) {
-		temp2 = nodes[genome2];
-	}
-	else {
-		temp2 = new GenomeNode(genome2);
+	addEdge(gen1, gen2, homology);
+}
 
-		nodes[genome2] = temp2;
+//Add a connection between two interned genomes.
+void GenomeNetwork::addEdge(unsigned int gen1, unsigned int gen2, double homology) {
+
+	HomologyEdge edge;
+
+	edge.gen1 = gen1;
+	edge.gen2 = gen2;
+	edge.homology = homology;
+
+	edges.push_back(edge);
+
+	finalized = false;
+}
+
+//Make room for count more edges so they can be added without regrowing.
+void GenomeNetwork::reserveEdges(size_t count) {
+	edges.reserve(edges.size() + count);
+}
+
+/*
+Sort the edges by increasing homology.
+
+Edges with equal homology keep the order they were added in.
+*/
+void GenomeNetwork::finalize() {
+
+	if (finalized) return;
+
+	stable_sort(edges.begin(), edges.end(),
+		[](const HomologyEdge &lhs, const HomologyEdge &rhs) {
+			return lhs.homology < rhs.homology;
+		});
+
+	//The adjacency refers to edge ranks, so it has to be rebuilt
+	vector<size_t>().swap(offsets);
+	vector<unsigned int>().swap(adjacency);
+	vector<unsigned int>().swap(adjacencyRank);
+
+	removedEdges = 0;
+	finalized = true;
+}
+
+//Build the CSR adjacency from the sorted edges if it doesn't exist yet.
+void GenomeNetwork::buildAdjacency() {
+
+	finalize();
+
+	unsigned int n = names.size();
+
+	if (offsets.size() == n + 1) return;
+
+	//Count the degree of every node
+	offsets.assign(n + 1, 0);
+
+	for (auto &e : edges) {
+		++offsets[e.gen1 + 1];
+		++offsets[e.gen2 + 1];
 	}
 
-	//Create connection between the 2 nodes
-	(*temp1).addNeighbor(temp2, homology);
-	(*temp2).addNeighbor(temp1, homology);
+	for (unsigned int i = 0; i < n; ++i)
+		offsets[i + 1] += offsets[i];
+
+	//Place both directions of every edge in the adjacency arrays
+	adjacency.assign(offsets[n], 0);
+	adjacencyRank.assign(offsets[n], 0);
+
+	vector<size_t> next(offsets.begin(), offsets.end() - 1);
+
+	for (unsigned int rank = 0; rank < edges.size(); ++rank) {
 
+		unsigned int gen1 = edges[rank].gen1;
+		unsigned int gen2 = edges[rank].gen2;
+
+		adjacency[next[gen1]] = gen2;
+		adjacencyRank[next[gen1]++] = rank;
+
+		adjacency[next[gen2]] = gen1;
+		adjacencyRank[next[gen2]++] = rank;
+	}
 }
 
-//Add a homology edge to the list of homologies.
-void GenomeNetwork::addHomology(double homology, string gen1, string gen2) {
+/*
+Return the number of neighbors of the node and point neighbors and ranks
+at their ids and the ranks of the edges to them.
 
-	tuple<double, GenomeNode*, GenomeNode*> newTuple;
+precondition: buildAdjacency() has been called since the last edge was added
+*/
+size_t GenomeNetwork::getNeighbors(unsigned int node, const unsigned int * &neighbors,
+	const unsigned int * &ranks) {
 
-	get<0>(newTuple) = homology;
-	get<1>(newTuple) = getNode(gen1);
-	get<2>(newTuple) = getNode(gen2);
+	neighbors = adjacency.data() + offsets[node];
+	ranks = adjacencyRank.data() + offsets[node];
 
-	homologyConnections.insert(newTuple);
+	return offsets[node + 1] - offsets[node];
 }
 
 /*
 Remove edges from the graph until there are num_clusters clusters
-in the graph. 
+in the graph.
+
+The number of clusters can only grow as more edges are removed,
+so the number of edges to remove is found with a binary search.
 
 Then, find all families in the graph and add them to teh family vector
 */
 void GenomeNetwork::cluster(int cluster_num) {
 
-	//Remove edges until number of clusters is big enough
-	while (numClusters() < cluster_num) {
-		
-		//Find smallest edge
-		auto hom = *(homologyConnections.begin());
-		
-		int homology = get<0>(hom);
-
-		GenomeNode * gen1 = get<1>(hom);
-		GenomeNode * gen2 = get<2>(hom);
-		
-		//Remove smallest edge from its 2 nodes
-		(*gen1).removeNode(gen2, homology);
-		
-		(*gen2).removeNode(gen1, homology);
-		
-		//Remove edge from edge set
-		homologyConnections.erase(homologyConnections.begin());
-		
-	}
+	finalize();
+
+	//Find the smallest number of removed edges that gives enough clusters
+	unsigned int low = 0;
+	unsigned int high = edges.size();
 
-	//Store nodes in vector so they can be iterated through easily
-	vector<GenomeNode *> nodeVec;
+	while (low < high) {
 
-	for (auto g : nodes) {
-		nodeVec.push_back(g.second);
+		unsigned int mid = low + (high - low) / 2;
+
+		if (countClusters(mid) >= cluster_num)
+			high = mid;
+		else
+			low = mid + 1;
 	}
 
-	//Add each family to the family vector
-	for (int i = 0; i < numClusters(); ++i) {
+	removedEdges = low;
 
-		pair<string, vector<GenomeNode *>> temp;
+	//Label every node with its family
+	vector<unsigned int> labels;
 
-		temp.first = "Family " + to_string(i);
+	connectedComponents(names.size(), edges.data() + removedEdges,
+		edges.size() - removedEdges, numThreads, labels);
 
-		vector<GenomeNode *> newVec;
-		
-		for (auto i : nodeVec) {
-			
-			if (!(i->beenAdded)) {
-				
-				//Add nodes recursively to the vector
-				(*i).addFamily(newVec);
-				break;
-			}
-		}
+	setFamilies(labels);
+
+}
+
+/*
+Turn a label per genome into the family vector.
+
+Labels can be any number, they are renumbered in the order
+their first genome was added to the network.
+*/
+void GenomeNetwork::setFamilies(const vector<unsigned int> &labels) {
+
+	unordered_map<unsigned int, unsigned int> familyOf;
+
+	families.clear();
+
+	for (unsigned int i = 0; i < names.size(); ++i) {
+
+		auto itr = familyOf.find(labels[i]);
 
-		//Add information to family vector
-		temp.second = newVec;
+		unsigned int family;
 
-		families.push_back(temp);
+		if (itr == familyOf.end()) {
 
+			family = families.size();
+			familyOf.emplace(labels[i], family);
+
+			families.push_back(make_pair("Family " + to_string(family), vector<string>()));
+		}
+		else {
+			family = itr->second;
+		}
+
+		//Add genome to its family
+		families[family].second.push_back(names[i]);
 	}
 
 }
@@ -153,73 +247,69 @@ void GenomeNetwork::cluster(int cluster_num) {
 //Returns the number of clusters in the graph.
 int GenomeNetwork::numClusters() {
 
-	int numClusters = 0;
+	finalize();
 
-	unordered_map<string, GenomeNode*> temp = nodes;
+	return countClusters(removedEdges);
+}
 
-	vector<GenomeNode *> nodeVec;
+/*
+Returns the number of clusters in the graph when all edges
+with a rank below removed are ignored.
 
-	//Create a vector of all nodes to iterate easily
-	for (auto g : nodes) {
-		nodeVec.push_back(g.second);
-	}
+The edges that are left are a contiguous block at the end
+of the sorted edge array.
+*/
+int GenomeNetwork::countClusters(unsigned int removed) {
 
-	//For all nodes, clear cluster by cluster.
-	//Each time 1 cluster is cleared, increment number of clusters
-	for (auto i : nodeVec) {
-		if (!(i->searched)) {
-			numClusters++;
-			(*i).clear();
-		}
-	}
+	vector<unsigned int> labels;
 
-	//Reset all searched values.
-	reset();
+	return connectedComponents(names.size(), edges.data() + removed,
+		edges.size() - removed, numThreads, labels);
 
-	return numClusters;
+}
+
+//Set the number of threads used to find clusters.
+void GenomeNetwork::setThreads(int threads) {
+	numThreads = threads;
+}
 
+//Returns all edges of the network.
+const vector<HomologyEdge>& GenomeNetwork::getEdges() {
+	return edges;
 }
 
 //Returns vector of families.
-vector<pair<string, vector<GenomeNode *>>> GenomeNetwork::getFamilyVector() {
+vector<pair<string, vector<string>>> GenomeNetwork::getFamilyVector() {
 	return families;
 }
 
-//Returns pointer to given node
-//precondition: node must exist in network
-GenomeNode* GenomeNetwork::getNode(string genome) {
-	auto itr = nodes.find(genome);
-
-	return (*itr).second;
+//Returns the name of the genome with the given id
+//precondition: id must exist in network
+const string& GenomeNetwork::getName(unsigned int id) {
+	return names[id];
 }
 
 //Return true if node exists in network
-bool GenomeNetwork::hasNode(string genome) {
-	auto itr = nodes.find(genome);
-
-	return itr != nodes.end();
-}
+bool GenomeNetwork::hasNode(const string &genome) {
+	auto itr = ids.find(genome);
 
-//Set all searched values to false
-void GenomeNetwork::reset() {
-	for (auto i : nodes)
-		(i.second)->searched = false;
+	return itr != ids.end();
 }
 
 //Print graph for debugging
 void GenomeNetwork::print() {
 
-	cout << "PRINTING" << endl;
-	for (auto i : nodes) {
-		/*cout << i.second->name;
+	buildAdjacency();
 
-		for (auto j : i.second->neighbors)
-			if (get<2>(j))
-				cout << get<0>(j)->name << endl;
+	cout << "PRINTING" << endl;
+	for (unsigned int i = 0; i < names.size(); ++i) {
 
-		cout << endl;*/
+		cout << names[i] << endl;
 
-		//cout << i.second->searched << endl;
+		for (size_t k = offsets[i]; k < offsets[i + 1]; ++k)
+			if (adjacencyRank[k] >= removedEdges)
+				cout << "\t" << names[adjacency[k]] << "\t"
+					<< edges[adjacencyRank[k]].homology << endl;
 	}
 	cout << "END" << endl;
 }
@@ -227,5 +317,10 @@ void GenomeNetwork::print() {
 
 //Return number of nodes
 int GenomeNetwork::numNodes() {
-	return nodes.size();
+	return names.size();
+}
+
+//Return number of edges
+size_t GenomeNetwork::numEdges() {
+	return edges.size();
 }
\ No newline at end of file
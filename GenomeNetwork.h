@@ -6,61 +6,87 @@ GenomeNetwork.h
 This class represents a network of genomes
 related by how homologous they are to eachother.
 
-The network is mad up of a set of GenomeNodes, each one represents
-a different species. The nodes are connected to each other through
-pointers with each pointer corresponding to a certain homology,
-or degree of similarity.
+Every genome name is interned to a dense integer id the first time
+it is read, so the rest of the network never hashes or compares strings.
+Homology edges are kept in one contiguous array of (id, id, homology)
+records which is sorted by homology once the input has been read.
+When a walk over the neighbors of a node is needed, a compressed sparse
+row (CSR) adjacency is built from that array: the neighbors of node i
+are stored in adjacency[offsets[i]] to adjacency[offsets[i + 1] - 1],
+together with the rank of the edge that connects them in the sorted
+edge array.
 
 Using the graph, genomes can be clustered into families based on
-how related they are to each other. The clustering usis achieved using a markov-like
-algorithm that removes the least homologous edges one by one until the number of clusters
-is equivalent to the number predefined.
+how related they are to each other. The clustering removes the least
+homologous edges one by one until the number of clusters is equivalent
+to the number predefined.
 
-I use a clustering algorithm to cluster all of the species into 
+Because the edges are sorted, removing the k least homologous edges
+is the same as ignoring every edge with a rank below k, so no edge is
+ever physically removed from the graph. The edges that are left are
+a contiguous block of the edge array, and the clusters are found by
+running a parallel connected components search over that block.
+
+I use a clustering algorithm to cluster all of the species into
 a number of families predefined by the user.
 */
 
 #ifndef GENOMENETWORK_H
 #define GENOMENETWORK_H
 
-#include "GenomeNode.h"
-
 #include <string>
 #include <vector>
 #include <unordered_map>
-#include <set>
 
 using namespace std;
 
-//This is used to keep the list of homology edges in decreasing order
-//so that they can be removed from the graph in order. During clustering
-struct SetComp {
-
-	//How to compare tuples
-	bool operator()(const tuple<double, GenomeNode*, GenomeNode*> lhs, 
-		const tuple<double, GenomeNode*, GenomeNode*> rhs) const {
+//A single homology edge between two interned genomes
+struct HomologyEdge {
 
-		return get<0>(lhs) < get<0>(rhs);
-	}
+	unsigned int gen1;
+	unsigned int gen2;
+	float homology;
 };
 
 class GenomeNetwork {
 
 private:
-	//Hashmap of all nodes
-	unordered_map<string, GenomeNode*> nodes;
+	//Map from genome name to its interned id
+	unordered_map<string, unsigned int> ids;
 
-	//Vector of all families in the network
-	vector<pair<string, vector<GenomeNode *>>> families;
+	//Genome names indexed by id
+	vector<string> names;
 
 	/*
-	Set representatinve of all edges in the network
-	This set is used during clustering. It stores the homology connections
-	in decreasing order so the they can be removed from the graph
-	in decreasing order.
+	All edges in the network.
+	After finalize() the edges are sorted by increasing homology
+	so the position of an edge in this vector is its removal rank.
 	*/
-	set<tuple<double, GenomeNode*, GenomeNode*>> homologyConnections;
+	vector<HomologyEdge> edges;
+
+	//CSR adjacency, see the description at the top of the file.
+	//Empty until buildAdjacency() is called.
+	vector<size_t> offsets;
+	vector<unsigned int> adjacency;
+	vector<unsigned int> adjacencyRank;
+
+	//True once the edges have been sorted. The CSR arrays are built separately by buildAdjacency().
+	bool finalized;
 
+	//Edges with a rank below this value have been removed from the graph
+	unsigned int removedEdges;
+
+	//Number of threads used to find clusters
+	int numThreads;
+
+	//Vector of all families in the network
+	vector<pair<string, vector<string>>> families;
+
+	//Sort the edges if they are out of date
+	void finalize();
+
+	//Return the number of clusters if the first removed edges are ignored
+	int countClusters(unsigned int removed);
 
 public:
 
@@ -68,20 +94,51 @@ public:
 
 	~GenomeNetwork();
 
+	//Return the id of the genome, adding it to the network if needed.
+	unsigned int intern(const string &genome);
+
 	//Add a connection between the two genomes
-	void addSet(string genome1, string genome2, double homology);
+	void addSet(const string &genome1, const string &genome2, double homology);
+
+	//Add a connection between two genomes that were already interned
+	void addEdge(unsigned int gen1, unsigned int gen2, double homology);
+
+	//Make room for count more edges
+	void reserveEdges(size_t count);
 
 	//Return true if the graph contains the node
-	bool hasNode(string genome);
+	bool hasNode(const string &genome);
+
+	//Return the name of the genome with the given id
+	const string& getName(unsigned int id);
+
+	//Return all edges of the network
+	const vector<HomologyEdge>& getEdges();
+
+	/*
+	Build the CSR adjacency if it is out of date.
+	Must be called before getNeighbors() is used, and not while
+	other threads are using getNeighbors().
+	*/
+	void buildAdjacency();
 
-	//Add a homology edge to the homology set
-	void addHomology(double homology, string gen1, string gen2);
+	/*
+	Return the number of neighbors of the node. neighbors and ranks are
+	set to the ids of the neighbors and the ranks of the edges to them.
+	Can be used from several threads at once.
+	*/
+	size_t getNeighbors(unsigned int node, const unsigned int * &neighbors,
+		const unsigned int * &ranks);
 
-	//Get the given node from the network and return it
-	GenomeNode* getNode(string genome);
+	/*
+	Set the families from a label for every genome id.
+	Genomes with the same label are put in the same family. Families are
+	numbered in the order of their first genome.
+	*/
+	void setFamilies(const vector<unsigned int> &labels);
 
 	//Return the vector of families that have been calculated from the tree.
-	vector<pair<string, vector<GenomeNode *>>> getFamilyVector();
+	vector<pair<string, vector<string>>> getFamilyVector();
 
 	//Clustering algorithm that results in num_clusters clusters of genomes.
 	void cluster(int cluster_num);
@@ -89,8 +146,8 @@ public:
 	//Return the current number of clusters in the network
 	int numClusters();
 
-	//Set all nodes' searched variable to false
-	void reset();
+	//Set the number of threads used to find clusters
+	void setThreads(int threads);
 
 	//Print graph for debugging
 	void print();
@@ -98,6 +155,9 @@ public:
 	//Return number of nodes
 	int numNodes();
 
+	//Return number of edges
+	size_t numEdges();
+
 
 };
 
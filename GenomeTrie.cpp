@@ -60,13 +60,18 @@ void GenomeTrie::addSequence(string &sequence) {
 
 //Return true if the trie contains the given sequence.
 bool GenomeTrie::containsSequence(string &sequence) {
+	return containsSequence(sequence.data(), sequence.size());
+}
+
+//Return true if the trie contains the length characters starting at sequence.
+bool GenomeTrie::containsSequence(const char * sequence, int length) {
 
 	TrieNode * currNode = root;
 
 	//Iterate through trie, if next node isn't found, return false
-	for (char c : sequence) {
+	for (int i = 0; i < length; ++i) {
 
-		int val = charVal(c);
+		int val = charVal(sequence[i]);
 
 		if (val == -1) return false;
 
@@ -83,6 +88,78 @@ bool GenomeTrie::containsSequence(string &sequence) {
 
 }
 
+//Number of lookups countContained keeps in flight
+const int LOOKUP_GROUP = 16;
+
+size_t GenomeTrie::countContained(const char * sequences, size_t count, int length) {
+
+	//A lookup in flight: the node reached so far and how deep it is
+	struct Lookup {
+		TrieNode * node;
+		const char * sequence;
+		int depth;
+	};
+
+	Lookup group[LOOKUP_GROUP];
+
+	if (length <= 0)
+		return count;
+
+	size_t found = 0;
+	size_t next = 0;
+	int active = 0;
+
+	//Start the next sequence in a lookup slot. Return false if none are left.
+	auto start = [&](Lookup &lookup) {
+
+		if (next == count) return false;
+
+		lookup.node = root;
+		lookup.sequence = sequences + next * length;
+		lookup.depth = 0;
+
+		++next;
+		return true;
+	};
+
+	while (active < LOOKUP_GROUP && start(group[active]))
+		++active;
+
+	while (active > 0) {
+
+		//Move every lookup in the group down one level
+		for (int g = 0; g < active; ) {
+
+			Lookup &lookup = group[g];
+
+			int val = charVal(lookup.sequence[lookup.depth]);
+
+			TrieNode * child = val == -1 ? nullptr : lookup.node->nucleotides[val];
+
+			if (child && ++lookup.depth < length) {
+
+				//Read the child on the next pass, after the rest of the group
+				lookup.node = child;
+				__builtin_prefetch(child);
+
+				++g;
+				continue;
+			}
+
+			if (child)
+				++found;
+
+			//This lookup is done, reuse its slot
+			if (start(lookup))
+				++g;
+			else
+				lookup = group[--active];
+		}
+	}
+
+	return found;
+}
+
 //Assigns integer representaion (0-4) to each nucleotide.
 //If character is not a nucleotide, return -1.
 int GenomeTrie::charVal(char c) {
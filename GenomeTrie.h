@@ -45,6 +45,21 @@ public:
 	//Return true if the trie contains the given sequence.
 	bool containsSequence(string &sequence);
 
+	//Return true if the trie contains the length characters starting at sequence.
+	bool containsSequence(const char * sequence, int length);
+
+	/*
+	Return how many of count sequences, each length characters long and
+	stored one after another starting at sequences, the trie contains.
+
+	A group of lookups is walked down the trie together, one level at a
+	time, and the next node of each lookup is prefetched before any of
+	them is read. The cache misses of the group overlap instead of
+	following one another, which matters once the trie is larger than
+	the cache.
+	*/
+	size_t countContained(const char * sequences, size_t count, int length);
+
 };
 
 
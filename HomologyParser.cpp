@@ -0,0 +1,208 @@
+/*
+Armon Azizi
+
+HomologyParser.cpp
+
+Reads the homology table written by genomecompare into a GenomeNetwork.
+
+The file is mapped into memory and split into newline aligned chunks,
+one per thread. Each thread parses its chunk in place with from_chars
+and interns genome names into its own table. When all threads are done,
+the tables are merged into the network in file order, so the resulting
+ids and edge order are the same as reading the file line by line.
+*/
+
+#include "HomologyParser.h"
+#include "GenomeNetwork.h"
+#include "MappedFile.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <cstring>
+#include <charconv>
+#include <cmath>
+#include <iostream>
+
+using namespace std;
+
+//Everything one thread reads from its chunk of the file
+struct ParsedChunk {
+
+	//Local id of every genome name seen in the chunk
+	unordered_map<string_view, unsigned int> ids;
+
+	//Names in the order they were first seen, indexed by local id
+	vector<string_view> names;
+
+	//Edges between local ids
+	vector<HomologyEdge> edges;
+};
+
+/*
+Parse a single line of the homology table.
+
+Extra columns after the homology are ignored.
+*/
+bool parseHomologyLine(const char * begin, const char * end,
+	string_view &gen1, string_view &gen2, double &homology) {
+
+	const char * tab1 = (const char *)memchr(begin, '\t', end - begin);
+
+	if (!tab1) return false;
+
+	const char * tab2 = (const char *)memchr(tab1 + 1, '\t', end - tab1 - 1);
+
+	if (!tab2) return false;
+
+	gen1 = string_view(begin, tab1 - begin);
+	gen2 = string_view(tab1 + 1, tab2 - tab1 - 1);
+
+	const char * num = tab2 + 1;
+
+	while (num < end && *num == ' ')
+		++num;
+
+	return from_chars(num, end, homology).ec == errc();
+}
+
+//Return the local id of the name, adding it to the chunk if needed
+static unsigned int internLocal(ParsedChunk &chunk, string_view name) {
+
+	auto itr = chunk.ids.find(name);
+
+	if (itr != chunk.ids.end())
+		return itr->second;
+
+	unsigned int id = chunk.names.size();
+
+	chunk.ids.emplace(name, id);
+	chunk.names.push_back(name);
+
+	return id;
+}
+
+//Parse every line in [begin, end) into the chunk
+static void parseChunk(const char * begin, const char * end,
+	double minHomology, ParsedChunk &chunk) {
+
+	const char * line = begin;
+
+	while (line < end) {
+
+		const char * lineEnd = (const char *)memchr(line, '\n', end - line);
+
+		if (!lineEnd) lineEnd = end;
+
+		//Drop the carriage return of files written on windows
+		const char * contentEnd = lineEnd;
+
+		if (contentEnd > line && contentEnd[-1] == '\r')
+			--contentEnd;
+
+		string_view gen1;
+		string_view gen2;
+		double homology;
+
+		if (parseHomologyLine(line, contentEnd, gen1, gen2, homology)) {
+
+			//Both genomes are kept even if the edge is dropped, so they still get a family
+			HomologyEdge edge;
+
+			edge.gen1 = internLocal(chunk, gen1);
+			edge.gen2 = internLocal(chunk, gen2);
+			edge.homology = homology;
+
+			//genomecompare writes nan for genomes shorter than the sequence length
+			if (!(homology < minHomology) && !isnan(homology))
+				chunk.edges.push_back(edge);
+		}
+
+		line = lineEnd + 1;
+	}
+}
+
+/*
+Read the homology table into the network.
+
+The body of the file is split into numThreads pieces of roughly equal
+size. Each split point is moved forward to just past the next newline
+so no line is shared between two threads.
+*/
+bool parseHomologies(const string &fileName, GenomeNetwork &net,
+	double minHomology, int numThreads) {
+
+	MappedFile file(fileName);
+
+	if (!file.isOpen()) {
+		cout << "could not read " << fileName << endl;
+		return false;
+	}
+
+	const char * data = file.data();
+	const char * end = data + file.size();
+
+	//skip header
+	const char * body = (const char *)memchr(data, '\n', file.size());
+
+	body = body ? body + 1 : end;
+
+	if (numThreads < 1)
+		numThreads = 1;
+
+	//Find newline aligned chunk boundaries
+	vector<const char *> bounds;
+
+	bounds.push_back(body);
+
+	for (int t = 1; t < numThreads; ++t) {
+
+		const char * split = body + (end - body) * t / numThreads;
+
+		if (split < bounds.back())
+			split = bounds.back();
+
+		const char * newline = (const char *)memchr(split, '\n', end - split);
+
+		bounds.push_back(newline ? newline + 1 : end);
+	}
+
+	bounds.push_back(end);
+
+	//Parse all chunks in parallel
+	vector<ParsedChunk> chunks(numThreads);
+	vector<thread> threads;
+
+	for (int t = 0; t < numThreads; ++t)
+		threads.emplace_back(parseChunk, bounds[t], bounds[t + 1],
+			minHomology, ref(chunks[t]));
+
+	for (auto &t : threads)
+		t.join();
+
+	size_t totalEdges = 0;
+
+	for (auto &chunk : chunks)
+		totalEdges += chunk.edges.size();
+
+	net.reserveEdges(totalEdges);
+
+	//Merge the local tables into the network in file order
+	for (auto &chunk : chunks) {
+
+		vector<unsigned int> remap(chunk.names.size());
+
+		for (unsigned int i = 0; i < chunk.names.size(); ++i)
+			remap[i] = net.intern(string(chunk.names[i]));
+
+		for (auto &e : chunk.edges)
+			net.addEdge(remap[e.gen1], remap[e.gen2], e.homology);
+
+		//Release the chunk before the next one grows the network
+		chunk = ParsedChunk();
+	}
+
+	return true;
+}
\ No newline at end of file
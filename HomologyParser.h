@@ -0,0 +1,52 @@
+/*
+Armon Azizi
+
+HomologyParser.h
+
+Reads the homology table written by genomecompare into a GenomeNetwork.
+
+The file is mapped into memory and split into newline aligned chunks,
+one per thread. Each thread parses its chunk in place with from_chars
+and interns genome names into its own table. When all threads are done,
+the tables are merged into the network in file order, so the resulting
+ids and edge order are the same as reading the file line by line.
+
+Edges with a homology below a given minimum are dropped while parsing
+and never stored, but their genomes are still added to the network.
+*/
+
+#ifndef HOMOLOGYPARSER_H
+#define HOMOLOGYPARSER_H
+
+#include "GenomeNetwork.h"
+
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+/*
+Parse a single line of the homology table, not including the newline.
+
+Return false if the line does not have the form
+GENOME1<TAB>GENOME2<TAB>HOMOLOGY_PERCENT
+*/
+bool parseHomologyLine(const char * begin, const char * end,
+	string_view &gen1, string_view &gen2, double &homology);
+
+/*
+Read the homology table in fileName into the network using numThreads threads.
+
+The first line of the file is a header and is skipped.
+Blank or malformed lines are skipped, and so are edges with a homology
+below minHomology or that is not a number. The genomes of a skipped edge
+are still interned, so a genome with only weak edges becomes a family of
+its own.
+
+Return false if the file could not be read.
+*/
+bool parseHomologies(const string &fileName, GenomeNetwork &net,
+	double minHomology, int numThreads);
+
+
+#endif // HOMOLOGYPARSER_H
\ No newline at end of file
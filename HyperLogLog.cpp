@@ -0,0 +1,40 @@
+/*
+Armon Azizi
+
+HyperLogLog.cpp
+
+Estimates the number of distinct values in a stream using a fixed
+amount of memory.
+*/
+
+#include "HyperLogLog.h"
+
+#include <vector>
+#include <cmath>
+
+using namespace std;
+
+HyperLogLog::HyperLogLog() : registers(1 << PRECISION, 0) {}
+
+double HyperLogLog::estimate() {
+
+	double m = registers.size();
+
+	double sum = 0;
+	unsigned int empty = 0;
+
+	for (unsigned char rank : registers) {
+		sum += ldexp(1.0, -rank);
+		if (rank == 0) ++empty;
+	}
+
+	double alpha = 0.7213 / (1 + 1.079 / m);
+
+	double raw = alpha * m * m / sum;
+
+	//Small counts are estimated better from the number of empty registers
+	if (raw <= 2.5 * m && empty > 0)
+		return m * log(m / empty);
+
+	return raw;
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+/*
+Armon Azizi
+
+HyperLogLog.h
+
+Estimates the number of distinct values in a stream using a fixed
+amount of memory.
+
+Every value is hashed. The first bits of the hash choose a register,
+and the register keeps the longest run of leading zeros seen in the rest
+of the hash. Long runs are rare, so the runs in all registers together
+estimate how many distinct values were seen. With 2^14 registers the
+estimate is usually within 1% of the true count.
+*/
+
+#ifndef HYPERLOGLOG_H
+#define HYPERLOGLOG_H
+
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+class HyperLogLog {
+
+public:
+
+	HyperLogLog();
+
+	//Add a value, given as a well mixed 64 bit hash
+	void add(uint64_t hash) {
+
+		unsigned int reg = hash >> (64 - PRECISION);
+
+		//Leading zeros of the remaining bits, plus one
+		uint64_t rest = (hash << PRECISION) | ((uint64_t)1 << (PRECISION - 1));
+		unsigned char rank = __builtin_clzll(rest) + 1;
+
+		if (rank > registers[reg])
+			registers[reg] = rank;
+	}
+
+	//Return the estimated number of distinct values added
+	double estimate();
+
+private:
+
+	static const int PRECISION = 14;
+
+	vector<unsigned char> registers;
+};
+
+
+#endif // HYPERLOGLOG_H
\ No newline at end of file
@@ -0,0 +1,686 @@
+/*
+Armon Azizi
+
+KmerIndex.cpp
+
+The index of one genome's sequences that other genomes are mapped onto,
+in the layout that suits the genome.
+*/
+
+#include "KmerIndex.h"
+#include "KmerScanner.h"
+#include "HyperLogLog.h"
+#include "GenomeComparison.h"
+#include "GenomeTrie.h"
+#include "Parallel.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+using namespace std;
+
+//Genomes with at least one distinct sequence per this many possible sequences use a bitmap
+const double DENSE_SPACING = 64;
+
+//Genomes with fewer than one distinct sequence per this many possible sequences use a sorted array
+const double SPARSE_SPACING = 1 << 20;
+
+//One bit for every possible sequence
+class BitmapSet {
+
+public:
+
+	BitmapSet(int seqLen, const SequenceEstimate &)
+		: words(max((uint64_t)1, ((uint64_t)1 << (2 * seqLen)) / 64), 0) {}
+
+	void insert(uint64_t code) {
+		words[code >> 6] |= (uint64_t)1 << (code & 63);
+	}
+
+	void finish() {}
+
+	bool contains(uint64_t code) {
+		return (words[code >> 6] >> (code & 63)) & 1;
+	}
+
+	void prefetch(uint64_t code) {
+		__builtin_prefetch(&words[code >> 6]);
+	}
+
+	size_t memoryUsage() { return words.size() * sizeof(uint64_t); }
+
+private:
+
+	vector<uint64_t> words;
+};
+
+//Open addressing hash table of packed sequences, sized from the estimate
+class HashSet {
+
+public:
+
+	HashSet(int, const SequenceEstimate &estimate) : size(0), hasEmptyCode(false) {
+
+		//At most half full if the estimate is right
+		uint64_t capacity = 16;
+
+		while (capacity < 2 * estimate.distinct)
+			capacity <<= 1;
+
+		resize(capacity);
+	}
+
+	void insert(uint64_t code) {
+
+		//The code used to mark empty slots is stored on the side
+		if (code == EMPTY) {
+			hasEmptyCode = true;
+			return;
+		}
+
+		uint64_t slot = hashSequence(code) & mask;
+
+		while (slots[slot] != EMPTY) {
+
+			if (slots[slot] == code) return;
+
+			slot = (slot + 1) & mask;
+		}
+
+		slots[slot] = code;
+
+		//Only happens if the estimate was far too low
+		if (++size * 4 > slots.size() * 3)
+			resize(slots.size() * 2);
+	}
+
+	void finish() {}
+
+	bool contains(uint64_t code) {
+
+		if (code == EMPTY) return hasEmptyCode;
+
+		uint64_t slot = hashSequence(code) & mask;
+
+		while (slots[slot] != EMPTY) {
+
+			if (slots[slot] == code) return true;
+
+			slot = (slot + 1) & mask;
+		}
+
+		return false;
+	}
+
+	void prefetch(uint64_t code) {
+		__builtin_prefetch(&slots[hashSequence(code) & mask]);
+	}
+
+	size_t memoryUsage() { return slots.size() * sizeof(uint64_t); }
+
+private:
+
+	static constexpr uint64_t EMPTY = ~(uint64_t)0;
+
+	void resize(uint64_t capacity) {
+
+		vector<uint64_t> old(capacity, EMPTY);
+		old.swap(slots);
+
+		mask = capacity - 1;
+		size = 0;
+
+		for (uint64_t code : old)
+			if (code != EMPTY)
+				insert(code);
+	}
+
+	vector<uint64_t> slots;
+
+	uint64_t mask;
+
+	size_t size;
+
+	bool hasEmptyCode;
+};
+
+/*
+Sorted array of packed sequences.
+
+The directory holds where the sequences with each value of the leading
+bits start, with about one sequence per directory entry, so a lookup
+reads one directory entry and scans a few sequences.
+*/
+class SortedSet {
+
+public:
+
+	SortedSet(int seqLen, const SequenceEstimate &estimate) : codeBits(2 * seqLen), shift(0) {
+		codes.reserve(estimate.valid);
+	}
+
+	void insert(uint64_t code) {
+		codes.push_back(code);
+	}
+
+	void finish() {
+
+		sort(codes.begin(), codes.end());
+		codes.erase(unique(codes.begin(), codes.end()), codes.end());
+		codes.shrink_to_fit();
+
+		//About one sequence per directory entry
+		int bits = 1;
+
+		while (bits < codeBits && bits < 30 && ((size_t)1 << (bits + 1)) <= codes.size())
+			++bits;
+
+		shift = codeBits - bits;
+
+		directory.assign(((size_t)1 << bits) + 1, 0);
+
+		for (uint64_t code : codes)
+			++directory[(code >> shift) + 1];
+
+		for (size_t i = 1; i < directory.size(); ++i)
+			directory[i] += directory[i - 1];
+	}
+
+	bool contains(uint64_t code) {
+
+		uint64_t bucket = code >> shift;
+
+		for (size_t i = directory[bucket]; i < directory[bucket + 1]; ++i) {
+
+			if (codes[i] >= code)
+				return codes[i] == code;
+		}
+
+		return false;
+	}
+
+	//Only the directory entry, the sequences it points to can't be known before it is read
+	void prefetch(uint64_t code) {
+		__builtin_prefetch(&directory[code >> shift]);
+	}
+
+	size_t memoryUsage() {
+		return codes.capacity() * sizeof(uint64_t) + directory.size() * sizeof(size_t);
+	}
+
+private:
+
+	int codeBits;
+
+	int shift;
+
+	vector<uint64_t> codes;
+
+	vector<size_t> directory;
+};
+
+//Lookups are prefetched this many sequences ahead
+const size_t PREFETCH_DISTANCE = 16;
+
+//Sequences are handed to the indexes in batches of this size
+const size_t BATCH_SIZE = 4096;
+
+/*
+An index of packed sequences, stored in the given set.
+
+Length is int, or a FixedLength for an index compiled for one length.
+*/
+template<typename Set, KmerIndex::Layout LAYOUT, typename Length>
+class PackedIndex : public KmerIndex {
+
+public:
+
+	PackedIndex(Length seqLen, const SequenceEstimate &estimate)
+		: seqLen(seqLen), sequences(seqLen, estimate) {}
+
+	Layout layout() { return LAYOUT; }
+
+	void build(const string &fileName) {
+
+		scanSequences(fileName, seqLen, FixedLength<1>(), [&](uint64_t code, bool valid) {
+			if (valid) sequences.insert(code);
+		});
+
+		sequences.finish();
+	}
+
+	void countMapped(const string &fileName, size_t &mapped, size_t &total) {
+
+		mapped = 0;
+		total = 0;
+
+		vector<uint64_t> batch;
+		batch.reserve(BATCH_SIZE);
+
+		scanSequences(fileName, seqLen, seqLen, [&](uint64_t code, bool valid) {
+
+			++total;
+
+			if (!valid) return;
+
+			batch.push_back(code);
+
+			if (batch.size() == BATCH_SIZE) {
+				mapped += countFound(batch.data(), batch.size());
+				batch.clear();
+			}
+		});
+
+		mapped += countFound(batch.data(), batch.size());
+	}
+
+	void insert(const uint64_t * codes, size_t count) {
+		for (size_t i = 0; i < count; ++i)
+			sequences.insert(codes[i]);
+	}
+
+	void finish() {
+		sequences.finish();
+	}
+
+	//The memory of each lookup is prefetched a few lookups ahead, so the cache misses overlap
+	size_t countFound(const uint64_t * codes, size_t count) {
+
+		size_t found = 0;
+
+		for (size_t i = 0; i < count && i < PREFETCH_DISTANCE; ++i)
+			sequences.prefetch(codes[i]);
+
+		for (size_t i = 0; i < count; ++i) {
+
+			if (i + PREFETCH_DISTANCE < count)
+				sequences.prefetch(codes[i + PREFETCH_DISTANCE]);
+
+			if (sequences.contains(codes[i]))
+				++found;
+		}
+
+		return found;
+	}
+
+	size_t countFoundText(const char * text, size_t count) {
+
+		vector<uint64_t> codes;
+		codes.reserve(count);
+
+		for (size_t i = 0; i < count; ++i) {
+
+			const char * sequence = text + i * seqLen;
+
+			//No early exit, so a fixed length unrolls completely
+			uint64_t code = 0;
+			unsigned char invalid = 0;
+
+			for (int p = 0; p < seqLen; ++p) {
+				unsigned char val = nucleotideCodes.codes[(unsigned char)sequence[p]];
+				invalid |= val & 4;
+				code = (code << 2) | (val & 3);
+			}
+
+			//Sequences with other characters are never found
+			if (!invalid)
+				codes.push_back(code);
+		}
+
+		return countFound(codes.data(), codes.size());
+	}
+
+	size_t memoryUsage() { return sequences.memoryUsage(); }
+
+private:
+
+	Length seqLen;
+
+	Set sequences;
+};
+
+//The GenomeTrie, for sequences of any length
+class TrieIndex : public KmerIndex {
+
+public:
+
+	TrieIndex(int seqLen) : seqLen(seqLen), nodes(0) {}
+
+	Layout layout() { return TRIE; }
+
+	void build(const string &fileName) {
+		buildTrie(fileName, trie, seqLen);
+	}
+
+	void countMapped(const string &fileName, size_t &mapped, size_t &total) {
+		getMappedCounts(fileName, trie, seqLen, mapped, total);
+	}
+
+	/*
+	The trie is only used for sequences longer than MAX_PACKED_LENGTH,
+	which can't be packed, so it is never handed packed sequences.
+	*/
+	void insert(const uint64_t *, size_t) {
+		assert(seqLen <= MAX_PACKED_LENGTH);
+	}
+
+	void finish() {}
+
+	size_t countFound(const uint64_t *, size_t) {
+		assert(seqLen <= MAX_PACKED_LENGTH);
+		return 0;
+	}
+
+	size_t countFoundText(const char * sequences, size_t count) {
+		return trie.countContained(sequences, count, seqLen);
+	}
+
+	//Count the nodes the first time, with what the allocator adds to each
+	size_t memoryUsage() {
+
+		if (nodes == 0)
+			nodes = countNodes(trie.root);
+
+		return nodes * (sizeof(TrieNode) + 16);
+	}
+
+private:
+
+	static size_t countNodes(TrieNode * node) {
+
+		size_t count = 1;
+
+		for (TrieNode * child : node->nucleotides)
+			if (child)
+				count += countNodes(child);
+
+		return count;
+	}
+
+	int seqLen;
+
+	GenomeTrie trie;
+
+	size_t nodes;
+};
+
+const char * layoutName(KmerIndex::Layout layout) {
+
+	switch (layout) {
+		case KmerIndex::BITMAP: return "bitmap";
+		case KmerIndex::HASH: return "hash";
+		case KmerIndex::SORTED: return "sorted";
+		default: return "trie";
+	}
+}
+
+SequenceEstimate estimateSequences(const string &fileName, int seqLen) {
+
+	HyperLogLog counter;
+
+	SequenceEstimate estimate;
+	estimate.valid = 0;
+
+	dispatchLength(seqLen, [&](auto length) {
+		scanSequences(fileName, length, FixedLength<1>(), [&](uint64_t code, bool valid) {
+			if (valid) {
+				counter.add(hashSequence(code));
+				++estimate.valid;
+			}
+		});
+	});
+
+	estimate.distinct = min(counter.estimate(), (double)estimate.valid);
+
+	return estimate;
+}
+
+vector<SequenceEstimate> estimateSequences(const string &fileName, const vector<int> &seqLens) {
+
+	vector<HyperLogLog> counters(seqLens.size());
+	vector<SequenceEstimate> estimates(seqLens.size(), SequenceEstimate{0, 0});
+
+	scanSequences(fileName, seqLens, vector<int>(seqLens.size(), 1),
+		[&](size_t l, uint64_t code, bool valid) {
+			if (valid) {
+				counters[l].add(hashSequence(code));
+				++estimates[l].valid;
+			}
+		});
+
+	for (size_t l = 0; l < seqLens.size(); ++l)
+		estimates[l].distinct = min(counters[l].estimate(), (double)estimates[l].valid);
+
+	return estimates;
+}
+
+KmerIndex::Layout chooseLayout(int seqLen, double distinct) {
+
+	if (seqLen > MAX_PACKED_LENGTH)
+		return KmerIndex::TRIE;
+
+	double possible = pow(4.0, seqLen);
+
+	if (distinct * DENSE_SPACING >= possible)
+		return KmerIndex::BITMAP;
+
+	if (distinct * SPARSE_SPACING >= possible)
+		return KmerIndex::HASH;
+
+	return KmerIndex::SORTED;
+}
+
+size_t estimateMemory(KmerIndex::Layout layout, int seqLen, const SequenceEstimate &estimate) {
+
+	switch (layout) {
+
+		case KmerIndex::BITMAP:
+			return max((uint64_t)1, ((uint64_t)1 << (2 * seqLen)) / 64) * sizeof(uint64_t);
+
+		case KmerIndex::HASH: {
+			uint64_t capacity = 16;
+			while (capacity < 2 * estimate.distinct)
+				capacity <<= 1;
+			return capacity * sizeof(uint64_t);
+		}
+
+		//Every valid sequence is held before the repeats are removed
+		case KmerIndex::SORTED:
+			return estimate.valid * sizeof(uint64_t) + (size_t)estimate.distinct * sizeof(size_t);
+
+		//Each level has at most one node per distinct sequence
+		default: {
+			double nodes = 1;
+			for (int depth = 1; depth <= seqLen; ++depth)
+				nodes += min(pow(4.0, depth), estimate.distinct);
+			return (size_t)(nodes * (sizeof(TrieNode) + 16));
+		}
+	}
+}
+
+//Packed indexes are compiled for every length from MIN_FIXED_LENGTH to MAX_PACKED_LENGTH
+unique_ptr<KmerIndex> createIndex(KmerIndex::Layout layout, int seqLen, const SequenceEstimate &estimate) {
+
+	if (layout == KmerIndex::TRIE)
+		return unique_ptr<KmerIndex>(new TrieIndex(seqLen));
+
+	return dispatchLength(seqLen, [&](auto length) -> unique_ptr<KmerIndex> {
+
+		typedef decltype(length) Length;
+
+		switch (layout) {
+			case KmerIndex::BITMAP:
+				return unique_ptr<KmerIndex>(new PackedIndex<BitmapSet, KmerIndex::BITMAP, Length>(length, estimate));
+			case KmerIndex::HASH:
+				return unique_ptr<KmerIndex>(new PackedIndex<HashSet, KmerIndex::HASH, Length>(length, estimate));
+			default:
+				return unique_ptr<KmerIndex>(new PackedIndex<SortedSet, KmerIndex::SORTED, Length>(length, estimate));
+		}
+	});
+}
+
+void buildIndexes(const string &fileName, const vector<int> &seqLens,
+	vector<unique_ptr<KmerIndex>> &indexes) {
+
+	vector<vector<uint64_t>> batches(seqLens.size());
+
+	for (auto &batch : batches)
+		batch.reserve(BATCH_SIZE);
+
+	scanSequences(fileName, seqLens, vector<int>(seqLens.size(), 1),
+		[&](size_t l, uint64_t code, bool valid) {
+
+			if (!valid) return;
+
+			batches[l].push_back(code);
+
+			if (batches[l].size() == BATCH_SIZE) {
+				indexes[l]->insert(batches[l].data(), BATCH_SIZE);
+				batches[l].clear();
+			}
+		});
+
+	for (size_t l = 0; l < seqLens.size(); ++l) {
+		indexes[l]->insert(batches[l].data(), batches[l].size());
+		indexes[l]->finish();
+	}
+}
+
+/*
+Count the sequences of a genome of a single length found in several
+indexes, with the genome split over numThreads threads. Every thread
+keeps its own batch and counts, and the counts are added up at the end.
+*/
+static void countMappedParallel(const string &fileName, int seqLen, const vector<KmerIndex *> &indexes,
+	vector<size_t> &mapped, size_t &total, int numThreads) {
+
+	//On its own cache line, so threads don't slow each other down
+	struct alignas(64) ThreadState {
+		vector<uint64_t> batch;
+		vector<size_t> mapped;
+		size_t total;
+	};
+
+	vector<ThreadState> threads(numThreads);
+
+	for (auto &state : threads) {
+		state.batch.reserve(BATCH_SIZE);
+		state.mapped.assign(indexes.size(), 0);
+		state.total = 0;
+	}
+
+	auto search = [&](int thread) {
+
+		ThreadState &state = threads[thread];
+
+		for (size_t x = 0; x < indexes.size(); ++x)
+			state.mapped[x] += indexes[x]->countFound(state.batch.data(), state.batch.size());
+
+		state.batch.clear();
+	};
+
+	auto onSequence = [&](uint64_t code, bool valid, int thread) {
+
+		ThreadState &state = threads[thread];
+
+		++state.total;
+
+		if (!valid) return;
+
+		state.batch.push_back(code);
+
+		if (state.batch.size() == BATCH_SIZE)
+			search(thread);
+	};
+
+	dispatchLength(seqLen, [&](auto length) {
+		scanSequencesParallel(fileName, length, length, numThreads, onSequence, search);
+	});
+
+	for (auto &state : threads) {
+
+		total += state.total;
+
+		for (size_t x = 0; x < indexes.size(); ++x)
+			mapped[x] += state.mapped[x];
+	}
+}
+
+void countMapped(const string &fileName, const vector<int> &seqLens,
+	const vector<vector<KmerIndex *>> &indexes, vector<vector<size_t>> &mapped, vector<size_t> &total,
+	int numThreads) {
+
+	mapped.resize(seqLens.size());
+	total.assign(seqLens.size(), 0);
+
+	for (size_t l = 0; l < seqLens.size(); ++l)
+		mapped[l].assign(indexes[l].size(), 0);
+
+	//Sequences too long to pack are searched for as text, a range of sequences per thread
+	if (seqLens.size() == 1 && seqLens[0] > MAX_PACKED_LENGTH) {
+
+		string sequences = getQuerySequences(fileName, seqLens[0]);
+
+		total[0] = sequences.size() / seqLens[0];
+
+		vector<vector<size_t>> threadMapped(max(numThreads, 1), vector<size_t>(indexes[0].size(), 0));
+
+		parallelFor(total[0], BATCH_SIZE, numThreads, [&](size_t begin, size_t end, int thread) {
+			for (size_t x = 0; x < indexes[0].size(); ++x)
+				threadMapped[thread][x] += indexes[0][x]->countFoundText(
+					sequences.data() + begin * seqLens[0], end - begin);
+		});
+
+		for (auto &counts : threadMapped)
+			for (size_t x = 0; x < counts.size(); ++x)
+				mapped[0][x] += counts[x];
+
+		return;
+	}
+
+	if (seqLens.size() == 1 && numThreads > 1) {
+		countMappedParallel(fileName, seqLens[0], indexes[0], mapped[0], total[0], numThreads);
+		return;
+	}
+
+	vector<vector<uint64_t>> batches(seqLens.size());
+
+	for (auto &batch : batches)
+		batch.reserve(BATCH_SIZE);
+
+	//Search every index of a length for a batch
+	auto search = [&](size_t l) {
+		for (size_t x = 0; x < indexes[l].size(); ++x)
+			mapped[l][x] += indexes[l][x]->countFound(batches[l].data(), batches[l].size());
+		batches[l].clear();
+	};
+
+	auto onSequence = [&](size_t l, uint64_t code, bool valid) {
+
+		++total[l];
+
+		if (!valid) return;
+
+		batches[l].push_back(code);
+
+		if (batches[l].size() == BATCH_SIZE)
+			search(l);
+	};
+
+	//A single length uses the simpler scan, compiled for the length
+	if (seqLens.size() == 1)
+		dispatchLength(seqLens[0], [&](auto length) {
+			scanSequences(fileName, length, length, [&](uint64_t code, bool valid) {
+				onSequence(0, code, valid);
+			});
+		});
+	else
+		scanSequences(fileName, seqLens, seqLens, onSequence);
+
+	for (size_t l = 0; l < seqLens.size(); ++l)
+		search(l);
+}
\ No newline at end of file
@@ -0,0 +1,132 @@
+/*
+Armon Azizi
+
+KmerIndex.h
+
+The index of one genome's sequences that other genomes are mapped onto.
+
+Which layout is best depends on how many distinct sequences the genome
+has compared to the 4^k possible sequences of length k:
+
+bitmap   one bit for every possible sequence, for dense genomes where
+         the bitmap is no larger than 8 bytes per distinct sequence
+hash     an open addressing hash table of packed sequences, for the
+         range in between
+sorted   a sorted array of packed sequences with a directory on their
+         leading bits, for sparse genomes where the sequences spread
+         evenly over the directory
+trie     the GenomeTrie, for sequences longer than 32 nucleotides,
+         which don't fit in a packed integer
+
+The number of distinct sequences is estimated with a HyperLogLog pass
+over the genome before the index is built, so the layout can be chosen
+and sized up front instead of growing while the genome is added. For
+sequences longer than 32 the estimate counts their last 32 nucleotides.
+*/
+
+#ifndef KMERINDEX_H
+#define KMERINDEX_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+using namespace std;
+
+class KmerIndex {
+
+public:
+
+	enum Layout { BITMAP, HASH, SORTED, TRIE };
+
+	virtual ~KmerIndex() {}
+
+	virtual Layout layout() = 0;
+
+	//Add every sequence of the genome, the same sequences buildTrie adds
+	virtual void build(const string &fileName) = 0;
+
+	/*
+	Count the sequences of a genome that are found in the index, and the
+	number searched for, the same way getMappedCounts does.
+	*/
+	virtual void countMapped(const string &fileName, size_t &mapped, size_t &total) = 0;
+
+	/*
+	Add a batch of valid packed sequences, for building from a scan shared
+	with other indexes. Only for sequences of at most MAX_PACKED_LENGTH.
+	*/
+	virtual void insert(const uint64_t * codes, size_t count) = 0;
+
+	//Called once all batches have been added
+	virtual void finish() = 0;
+
+	//Return how many of a batch of valid packed sequences are in the index, as for insert
+	virtual size_t countFound(const uint64_t * codes, size_t count) = 0;
+
+	/*
+	Return how many of count sequences, stored one after another as text
+	in the format getQuerySequences returns, are in the index.
+	*/
+	virtual size_t countFoundText(const char * sequences, size_t count) = 0;
+
+	//Approximate number of bytes used by the index
+	virtual size_t memoryUsage() = 0;
+};
+
+//Number of layouts, for tallying them
+const int NUM_LAYOUTS = 4;
+
+//Return the name of a layout
+const char * layoutName(KmerIndex::Layout layout);
+
+//What the HyperLogLog pass found out about a genome
+struct SequenceEstimate {
+
+	//Estimated number of distinct valid sequences
+	double distinct;
+
+	//Number of valid sequences, counting repeats
+	size_t valid;
+};
+
+//Read the genome once and estimate its number of distinct sequences
+SequenceEstimate estimateSequences(const string &fileName, int seqLen);
+
+//Estimate the distinct sequences of every length in a single pass over the genome
+vector<SequenceEstimate> estimateSequences(const string &fileName, const vector<int> &seqLens);
+
+//Return the layout that suits a genome with the given number of distinct sequences
+KmerIndex::Layout chooseLayout(int seqLen, double distinct);
+
+//Create an empty index with the given layout, sized for the estimate
+unique_ptr<KmerIndex> createIndex(KmerIndex::Layout layout, int seqLen, const SequenceEstimate &estimate);
+
+//Return roughly how many bytes an index with the given layout will need while it is built
+size_t estimateMemory(KmerIndex::Layout layout, int seqLen, const SequenceEstimate &estimate);
+
+/*
+Build the index of every length, indexes[l] for seqLens[l], from a single
+pass over the genome. The indexes must be created and empty.
+*/
+void buildIndexes(const string &fileName, const vector<int> &seqLens,
+	vector<unique_ptr<KmerIndex>> &indexes);
+
+/*
+Count the sequences of a genome found in several indexes from a single
+pass over the genome, as countMapped does for each one.
+
+indexes[l] are the indexes of length seqLens[l]. mapped[l][x] is set to
+the number found in indexes[l][x], and total[l] to the number searched for.
+
+With a single length the genome is split over numThreads threads, which
+search the indexes at the same time, giving the same counts. Several
+lengths are always read by one thread.
+*/
+void countMapped(const string &fileName, const vector<int> &seqLens,
+	const vector<vector<KmerIndex *>> &indexes, vector<vector<size_t>> &mapped, vector<size_t> &total,
+	int numThreads = 1);
+
+
+#endif // KMERINDEX_H
\ No newline at end of file
@@ -0,0 +1,472 @@
+/*
+Armon Azizi
+
+KmerScanner.h
+
+Reads the sequences of a genome from a fasta file as 2 bit
+packed integers, without building a string for every sequence.
+
+A genome is read the same way genomecompare reads it: header lines
+are skipped and all other lines are joined into one long sequence.
+Every nucleotide is stored in 2 bits (A = 0, G = 1, C = 2, T = 3, the
+same values GenomeTrie uses), so a sequence of up to 32 nucleotides
+fits in one 64 bit integer. A sequence that contains any other
+character is not valid.
+
+The sequences are the same ones genomecompare uses:
+with a stride of 1 these are the sequences buildTrie adds to a trie,
+with a stride of the sequence length these are the sequences
+getMappedPercentage searches for. In both cases the sequence that ends
+on the very last character of the genome is left out.
+
+The scans take the sequence length either as an int or as a
+FixedLength, which carries the length in its type. dispatchLength
+turns a length read at run time into a FixedLength for the common
+lengths, so the scans and the indexes built on them are compiled once
+for every such length, with the masks, bounds and strides as constants.
+*/
+
+#ifndef KMERSCANNER_H
+#define KMERSCANNER_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include <type_traits>
+#include <algorithm>
+
+#include "MappedFile.h"
+#include "Parallel.h"
+
+using namespace std;
+
+//Longest sequence that fits in a 64 bit code
+const int MAX_PACKED_LENGTH = 32;
+
+//Shortest length that gets its own compiled kernels, up to MAX_PACKED_LENGTH
+const int MIN_FIXED_LENGTH = 8;
+
+//A sequence length known at compile time, which converts to an int wherever one is used
+template<int K>
+using FixedLength = integral_constant<int, K>;
+
+/*
+Call fn with seqLen as a FixedLength if it is between MIN_FIXED_LENGTH
+and MAX_PACKED_LENGTH, and as an int otherwise, and return what fn returns.
+fn is called the same way for every length, so it is usually a generic lambda.
+*/
+template<int K = MIN_FIXED_LENGTH, typename Fn>
+auto dispatchLength(int seqLen, Fn &&fn) {
+
+	if constexpr (K > MAX_PACKED_LENGTH)
+		return fn(seqLen);
+	else {
+		if (seqLen == K)
+			return fn(FixedLength<K>());
+
+		return dispatchLength<K + 1>(seqLen, fn);
+	}
+}
+
+//2 bit code of every character, 4 if it is not a nucleotide
+struct NucleotideTable {
+	unsigned char codes[256];
+};
+
+constexpr NucleotideTable makeNucleotideTable() {
+
+	NucleotideTable table = {};
+
+	for (int i = 0; i < 256; ++i)
+		table.codes[i] = 4;
+
+	table.codes[(unsigned char)'A'] = 0;
+	table.codes[(unsigned char)'G'] = 1;
+	table.codes[(unsigned char)'C'] = 2;
+	table.codes[(unsigned char)'T'] = 3;
+
+	return table;
+}
+
+inline constexpr NucleotideTable nucleotideCodes = makeNucleotideTable();
+
+//Return a mask that keeps the last seqLen nucleotides of a code
+constexpr uint64_t sequenceMask(int seqLen) {
+	return seqLen >= MAX_PACKED_LENGTH ? ~(uint64_t)0 : ((uint64_t)1 << (2 * seqLen)) - 1;
+}
+
+//Spread the bits of a sequence code over a 64 bit hash
+inline uint64_t hashSequence(uint64_t code) {
+
+	code ^= code >> 33;
+	code *= 0xff51afd7ed558ccdULL;
+	code ^= code >> 33;
+	code *= 0xc4ceb9fe1a85ec53ULL;
+	code ^= code >> 33;
+
+	return code;
+}
+
+/*
+Call onSequence(code, valid) for every sequence of length seqLen
+that starts at a multiple of stride in the genome.
+
+Sequences longer than MAX_PACKED_LENGTH only keep their last
+MAX_PACKED_LENGTH nucleotides in the code.
+
+seqLen and stride are ints or FixedLengths.
+
+Return false if the file could not be read.
+*/
+template<typename Length, typename Stride, typename SequenceFn>
+bool scanSequences(const string &fileName, Length seqLen, Stride stride, SequenceFn onSequence) {
+
+	ifstream infile(fileName, ios::binary);
+
+	if (!infile)
+		return false;
+
+	const uint64_t mask = sequenceMask(seqLen);
+
+	uint64_t code = 0;
+
+	//Number of valid nucleotides in a row ending at the current position
+	int validRun = 0;
+
+	//Position of the next character in the joined sequence
+	size_t position = 0;
+
+	//Distance from the last sequence start, counted in starts
+	int phase = 0;
+
+	//A sequence is only passed on once another character follows it
+	bool pending = false;
+	uint64_t pendingCode = 0;
+	bool pendingValid = false;
+
+	bool lineStart = true;
+	bool header = false;
+
+	char buffer[1 << 16];
+
+	while (infile) {
+
+		infile.read(buffer, sizeof(buffer));
+
+		streamsize length = infile.gcount();
+
+		for (streamsize i = 0; i < length; ++i) {
+
+			char c = buffer[i];
+
+			if (c == '\n') {
+				lineStart = true;
+				header = false;
+				continue;
+			}
+
+			//skip fasta header lines
+			if (lineStart) {
+				lineStart = false;
+				header = c == '>';
+			}
+
+			if (header) continue;
+
+			if (pending) {
+				onSequence(pendingCode, pendingValid);
+				pending = false;
+			}
+
+			unsigned char val = nucleotideCodes.codes[(unsigned char)c];
+
+			if (val < 4) {
+				code = ((code << 2) | val) & mask;
+				++validRun;
+			}
+			else {
+				validRun = 0;
+			}
+
+			//A sequence ends here
+			if (position + 1 >= (size_t)seqLen) {
+
+				if (phase == 0) {
+					pending = true;
+					pendingCode = code;
+					pendingValid = validRun >= seqLen;
+				}
+
+				phase = phase + 1 == stride ? 0 : phase + 1;
+			}
+
+			++position;
+		}
+	}
+
+	return true;
+}
+
+/*
+Read the genome once for several sequence lengths at the same time.
+
+Call onSequence(l, code, valid) for every sequence of length seqLens[l]
+that starts at a multiple of strides[l], the same sequences
+scanSequences finds for that length. All lengths must be at most
+MAX_PACKED_LENGTH. One rolling code of the longest length is kept, and
+the code of a shorter sequence is its last nucleotides.
+
+Return false if the file could not be read.
+*/
+template<typename SequenceFn>
+bool scanSequences(const string &fileName, const vector<int> &seqLens,
+	const vector<int> &strides, SequenceFn onSequence) {
+
+	ifstream infile(fileName, ios::binary);
+
+	if (!infile)
+		return false;
+
+	//The same state scanSequences keeps, for every length
+	struct LengthState {
+		uint64_t mask;
+		size_t seqLen;
+		int stride;
+		int phase;
+		bool pending;
+		bool pendingValid;
+		uint64_t pendingCode;
+	};
+
+	size_t numLengths = seqLens.size();
+
+	vector<LengthState> states(numLengths);
+
+	for (size_t l = 0; l < numLengths; ++l)
+		states[l] = LengthState{sequenceMask(seqLens[l]), (size_t)seqLens[l], strides[l], 0, false, false, 0};
+
+	uint64_t code = 0;
+	size_t validRun = 0;
+	size_t position = 0;
+
+	bool lineStart = true;
+	bool header = false;
+
+	char buffer[1 << 16];
+
+	while (infile) {
+
+		infile.read(buffer, sizeof(buffer));
+
+		streamsize length = infile.gcount();
+
+		for (streamsize i = 0; i < length; ++i) {
+
+			char c = buffer[i];
+
+			if (c == '\n') {
+				lineStart = true;
+				header = false;
+				continue;
+			}
+
+			//skip fasta header lines
+			if (lineStart) {
+				lineStart = false;
+				header = c == '>';
+			}
+
+			if (header) continue;
+
+			for (size_t l = 0; l < numLengths; ++l) {
+				if (states[l].pending) {
+					onSequence(l, states[l].pendingCode, states[l].pendingValid);
+					states[l].pending = false;
+				}
+			}
+
+			unsigned char val = nucleotideCodes.codes[(unsigned char)c];
+
+			if (val < 4) {
+				code = (code << 2) | val;
+				++validRun;
+			}
+			else {
+				validRun = 0;
+			}
+
+			for (LengthState &state : states) {
+
+				//A sequence of this length ends here
+				if (position + 1 >= state.seqLen) {
+
+					if (state.phase == 0) {
+						state.pending = true;
+						state.pendingCode = code & state.mask;
+						state.pendingValid = validRun >= state.seqLen;
+					}
+
+					state.phase = state.phase + 1 == state.stride ? 0 : state.phase + 1;
+				}
+			}
+
+			++position;
+		}
+	}
+
+	return true;
+}
+
+//Pieces scanSequencesParallel cuts a genome into are at least this large
+const size_t MIN_PIECE_BYTES = 1 << 20;
+
+/*
+Find the same sequences as scanSequences with numThreads threads.
+
+The genome is cut into pieces that start at the beginning of a line, a
+few per thread. A first pass counts the nucleotides of every piece, so
+every piece knows the position in the joined sequence it starts at. In
+the second pass every piece is scanned on its own and passes on the
+sequences that start inside it at a multiple of stride, reading on into
+the next piece for the end of its last sequences. Every sequence is
+passed on exactly once, so counts add up to the same totals as a
+single scan, but the sequences come in no particular order.
+
+Call onSequence(code, valid, thread) for every sequence, and
+onPieceDone(thread) after the last sequence of every piece. thread is a
+number between 0 and numThreads - 1 for per thread state.
+
+Return false if the file could not be read.
+*/
+template<typename Length, typename Stride, typename SequenceFn, typename PieceFn>
+bool scanSequencesParallel(const string &fileName, Length seqLen, Stride stride, int numThreads,
+	SequenceFn onSequence, PieceFn onPieceDone) {
+
+	MappedFile file(fileName);
+
+	if (!file.isOpen())
+		return false;
+
+	const char * data = file.data();
+	size_t size = file.size();
+
+	const uint64_t mask = sequenceMask(seqLen);
+
+	//Cut the file at line starts
+	size_t numPieces = max((size_t)1, min((size_t)max(numThreads, 1) * 4, size / MIN_PIECE_BYTES));
+
+	vector<size_t> pieceStart(1, 0);
+
+	for (size_t p = 1; p < numPieces; ++p) {
+
+		size_t start = max(size * p / numPieces, pieceStart.back());
+
+		while (start < size && data[start - 1] != '\n')
+			++start;
+
+		if (start < size && start > pieceStart.back())
+			pieceStart.push_back(start);
+	}
+
+	pieceStart.push_back(size);
+
+	numPieces = pieceStart.size() - 1;
+
+	//Number of nucleotides in every piece, the same characters scanSequences joins
+	vector<size_t> position(numPieces + 1, 0);
+
+	parallelFor(numPieces, 1, numThreads, [&](size_t p, size_t, int) {
+
+		size_t count = 0;
+		bool lineStart = true;
+		bool header = false;
+
+		for (size_t i = pieceStart[p]; i < pieceStart[p + 1]; ++i) {
+
+			char c = data[i];
+
+			if (c == '\n') {
+				lineStart = true;
+				header = false;
+				continue;
+			}
+
+			if (lineStart) {
+				lineStart = false;
+				header = c == '>';
+			}
+
+			if (!header) ++count;
+		}
+
+		position[p + 1] = count;
+	});
+
+	//position[p] is where piece p starts in the joined sequence
+	for (size_t p = 1; p <= numPieces; ++p)
+		position[p] += position[p - 1];
+
+	size_t length = position[numPieces];
+
+	parallelFor(numPieces, 1, numThreads, [&](size_t p, size_t, int thread) {
+
+		uint64_t code = 0;
+		size_t validRun = 0;
+		size_t pos = position[p];
+
+		bool lineStart = true;
+		bool header = false;
+
+		for (size_t i = pieceStart[p]; i < size; ++i) {
+
+			char c = data[i];
+
+			if (c == '\n') {
+				lineStart = true;
+				header = false;
+				continue;
+			}
+
+			if (lineStart) {
+				lineStart = false;
+				header = c == '>';
+			}
+
+			if (header) continue;
+
+			//Sequences starting from here on belong to the next piece, and the
+			//sequence ending on the very last character is left out
+			if (pos + 1 >= length || (pos + 1 >= (size_t)seqLen && pos + 1 - seqLen >= position[p + 1]))
+				break;
+
+			unsigned char val = nucleotideCodes.codes[(unsigned char)c];
+
+			if (val < 4) {
+				code = ((code << 2) | val) & mask;
+				++validRun;
+			}
+			else {
+				validRun = 0;
+			}
+
+			//A sequence ends here, and started inside this piece
+			if (pos + 1 >= (size_t)seqLen) {
+
+				size_t sequenceStart = pos + 1 - seqLen;
+
+				if (sequenceStart >= position[p] && sequenceStart % stride == 0)
+					onSequence(code, validRun >= (size_t)seqLen, thread);
+			}
+
+			++pos;
+		}
+
+		onPieceDone(thread);
+	});
+
+	return true;
+}
+
+
+#endif // KMERSCANNER_H
\ No newline at end of file
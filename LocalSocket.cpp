@@ -0,0 +1,183 @@
+/*
+Armon Azizi
+
+LocalSocket.cpp
+
+Helpers for talking over a Unix domain socket, used by
+genomeserver and genomeclient.
+*/
+
+#include "LocalSocket.h"
+
+#include <string>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+using namespace std;
+
+//Fill in the address of the socket file. Return false if the path is too long.
+static bool localAddress(const string &path, sockaddr_un &address) {
+
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+
+	if (path.size() >= sizeof(address.sun_path))
+		return false;
+
+	strcpy(address.sun_path, path.c_str());
+
+	return true;
+}
+
+/*
+Return true if nobody is listening on the socket at the address, which
+is the case for the socket file of a server that didn't stop cleanly.
+Otherwise set errno to why not and return false.
+*/
+static bool isStaleSocket(const sockaddr_un &address) {
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+	if (fd < 0)
+		return false;
+
+	int result = connect(fd, (sockaddr *)&address, sizeof(address));
+	int reason = errno;
+
+	close(fd);
+
+	//A server is still listening
+	if (result == 0) {
+		errno = EADDRINUSE;
+		return false;
+	}
+
+	errno = reason;
+
+	return reason == ECONNREFUSED;
+}
+
+//Create a listening socket at path
+int listenLocal(const string &path) {
+
+	sockaddr_un address;
+
+	if (!localAddress(path, address)) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+
+	struct stat info;
+
+	//Only remove the socket file left by an earlier server, never another file
+	if (lstat(path.c_str(), &info) == 0) {
+
+		if (!S_ISSOCK(info.st_mode)) {
+			errno = EEXIST;
+			return -1;
+		}
+
+		if (!isStaleSocket(address))
+			return -1;
+
+		unlink(path.c_str());
+	}
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+	if (fd < 0)
+		return -1;
+
+	if (bind(fd, (sockaddr *)&address, sizeof(address)) < 0 || listen(fd, 16) < 0) {
+		int reason = errno;
+		close(fd);
+		errno = reason;
+		return -1;
+	}
+
+	return fd;
+}
+
+//Connect to the socket at path
+int connectLocal(const string &path) {
+
+	sockaddr_un address;
+
+	if (!localAddress(path, address))
+		return -1;
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+	if (fd < 0)
+		return -1;
+
+	if (connect(fd, (sockaddr *)&address, sizeof(address)) < 0) {
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+/*
+Read one line from the socket.
+
+Reads a byte at a time so nothing after the newline is consumed.
+Requests are a single short line, so this is cheap.
+*/
+bool readLine(int fd, string &line) {
+
+	line = "";
+
+	char c;
+	ssize_t n;
+
+	while ((n = read(fd, &c, 1)) == 1) {
+
+		if (c == '\n')
+			return true;
+
+		line += c;
+	}
+
+	//A timeout or error loses the whole line, even if part of it was read
+	if (n < 0)
+		return false;
+
+	return !line.empty();
+}
+
+//Make reads and writes on the socket give up after seconds
+bool setTimeout(int fd, int seconds) {
+
+	timeval timeout;
+
+	timeout.tv_sec = seconds;
+	timeout.tv_usec = 0;
+
+	return setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) == 0
+		&& setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) == 0;
+}
+
+//Write all of data to the socket
+bool writeAll(int fd, const string &data) {
+
+	size_t written = 0;
+
+	while (written < data.size()) {
+
+		ssize_t n = write(fd, data.data() + written, data.size() - written);
+
+		if (n <= 0)
+			return false;
+
+		written += n;
+	}
+
+	return true;
+}
\ No newline at end of file
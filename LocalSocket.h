@@ -0,0 +1,43 @@
+/*
+Armon Azizi
+
+LocalSocket.h
+
+Helpers for talking over a Unix domain socket, used by
+genomeserver and genomeclient.
+
+Requests and responses are plain text. A client connects, sends one
+request line and reads the response until the server closes the
+connection.
+*/
+
+#ifndef LOCALSOCKET_H
+#define LOCALSOCKET_H
+
+#include <string>
+
+using namespace std;
+
+/*
+Create a socket listening at path. Return -1, with errno set, on error.
+
+An existing file at path is only replaced if it is the socket of a server
+that is no longer running, which refuses connections. Any other file,
+or the socket of a running server, is left alone and is an error.
+*/
+int listenLocal(const string &path);
+
+//Connect to the socket at path. Return -1 on error.
+int connectLocal(const string &path);
+
+//Read one line, without the newline, from the socket. Return false if nothing was read or reading failed.
+bool readLine(int fd, string &line);
+
+//Make reads and writes on the socket fail after waiting seconds for the other side. Return false on error.
+bool setTimeout(int fd, int seconds);
+
+//Write all of data to the socket. Return false on error.
+bool writeAll(int fd, const string &data);
+
+
+#endif // LOCALSOCKET_H
\ No newline at end of file
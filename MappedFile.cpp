@@ -0,0 +1,85 @@
+/*
+Armon Azizi
+
+MappedFile.cpp
+
+This class maps a whole file into memory read only
+so that it can be parsed in place, without copying
+it line by line into strings.
+
+The mapping is released when the object is destroyed.
+*/
+
+#include "MappedFile.h"
+
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+//Empty files are not mapped, they point at this instead.
+static const char emptyFile[1] = { 0 };
+
+/*
+Open the file and map it into memory.
+
+If the file can't be opened or mapped, isOpen() returns false.
+*/
+MappedFile::MappedFile(const string &fileName) {
+
+	start = nullptr;
+	length = 0;
+
+	int fd = open(fileName.c_str(), O_RDONLY);
+
+	if (fd < 0) return;
+
+	struct stat info;
+
+	if (fstat(fd, &info) == 0) {
+
+		if (info.st_size == 0) {
+			start = emptyFile;
+		}
+		else {
+
+			void * map = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+			if (map != MAP_FAILED) {
+
+				start = (const char *)map;
+				length = info.st_size;
+
+				//The file is read front to back
+				madvise(map, length, MADV_SEQUENTIAL);
+			}
+		}
+	}
+
+	//The mapping stays valid after the descriptor is closed
+	close(fd);
+}
+
+//Unmap the file
+MappedFile::~MappedFile() {
+	if (start && length > 0)
+		munmap((void *)start, length);
+}
+
+//Return true if the file was opened.
+bool MappedFile::isOpen() {
+	return start != nullptr;
+}
+
+//Return a pointer to the first byte of the file
+const char * MappedFile::data() {
+	return start;
+}
+
+//Return the size of the file in bytes
+size_t MappedFile::size() {
+	return length;
+}
\ No newline at end of file
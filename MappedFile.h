@@ -0,0 +1,50 @@
+/*
+Armon Azizi
+
+MappedFile.h
+
+This class maps a whole file into memory read only
+so that it can be parsed in place, without copying
+it line by line into strings.
+
+The mapping is released when the object is destroyed.
+*/
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+
+using namespace std;
+
+class MappedFile {
+
+private:
+	//Start of the mapping, nullptr if the file could not be mapped
+	const char * start;
+
+	//Length of the file in bytes
+	size_t length;
+
+public:
+
+	MappedFile(const string &fileName);
+
+	~MappedFile();
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile& operator=(const MappedFile &) = delete;
+
+	//Return true if the file was opened. An empty file is valid.
+	bool isOpen();
+
+	//Return a pointer to the first byte of the file
+	const char * data();
+
+	//Return the size of the file in bytes
+	size_t size();
+
+};
+
+
+#endif // MAPPEDFILE_H
\ No newline at end of file
@@ -0,0 +1,360 @@
+/*
+Armon Azizi
+
+MarkovClustering.cpp
+
+This class clusters a GenomeNetwork with the Markov Cluster algorithm (MCL).
+
+The homology edges are turned into a column stochastic matrix which is
+repeatedly expanded (squared), pruned and inflated until the flow has
+collected in a few attractor genomes. Every genome belongs to the family
+of the attractor its column flows to.
+
+All steps are done in parallel over blocks of columns. Each block writes
+its columns into its own buffer and the buffers are then concatenated
+into the compressed matrix for the next iteration.
+*/
+
+#include "MarkovClustering.h"
+#include "GenomeNetwork.h"
+#include "Parallel.h"
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <cmath>
+#include <iostream>
+
+using namespace std;
+
+//Number of columns handed to a thread at a time
+static const size_t COLUMN_GRAIN = 256;
+
+MarkovClustering::MarkovClustering(double inflationPower, int threads) {
+	inflation = inflationPower;
+	pruneThreshold = 1e-4;
+	maxColumnEntries = 200;
+	maxNeighbors = 20;
+	chaosLimit = 1e-5;
+	maxIterations = 100;
+	numThreads = threads;
+	iterations = 0;
+	converged = false;
+}
+
+MarkovClustering::~MarkovClustering() {
+}
+
+/*
+Build a new matrix column by column in parallel.
+
+columnFn fills in column j and returns its chaos. The largest chaos of
+all columns is stored in chaos.
+*/
+void MarkovClustering::buildColumns(unsigned int numColumns,
+	const function<double(unsigned int, vector<Entry> &, int)> &columnFn,
+	vector<size_t> &start, vector<Entry> &entries, double &chaos) {
+
+	size_t numBlocks = (numColumns + COLUMN_GRAIN - 1) / COLUMN_GRAIN;
+
+	vector<vector<Entry>> blockEntries(numBlocks);
+	vector<double> threadChaos(max(numThreads, 1), 0);
+
+	start.assign(numColumns + 1, 0);
+
+	parallelFor(numColumns, COLUMN_GRAIN, numThreads, [&](size_t begin, size_t end, int t) {
+
+		vector<Entry> column;
+		vector<Entry> &out = blockEntries[begin / COLUMN_GRAIN];
+
+		for (size_t j = begin; j < end; ++j) {
+
+			column.clear();
+
+			double c = columnFn(j, column, t);
+
+			if (c > threadChaos[t])
+				threadChaos[t] = c;
+
+			start[j + 1] = column.size();
+			out.insert(out.end(), column.begin(), column.end());
+		}
+	});
+
+	chaos = *max_element(threadChaos.begin(), threadChaos.end());
+
+	for (unsigned int j = 0; j < numColumns; ++j)
+		start[j + 1] += start[j];
+
+	//Concatenate the blocks
+	entries.resize(start[numColumns]);
+
+	parallelFor(numBlocks, 1, numThreads, [&](size_t b, size_t, int) {
+
+		copy(blockEntries[b].begin(), blockEntries[b].end(),
+			entries.begin() + start[b * COLUMN_GRAIN]);
+
+		vector<Entry>().swap(blockEntries[b]);
+	});
+}
+
+/*
+Drop small entries from the column, keep at most maxColumnEntries of
+the largest ones, then inflate and normalize what is left.
+
+The chaos of a column is its largest entry minus the sum of its squared
+entries. It is zero exactly when all entries are equal, which is the
+state every column reaches once the matrix has converged.
+*/
+double MarkovClustering::pruneAndInflate(vector<Entry> &column) {
+
+	if (column.empty())
+		return 0;
+
+	float largest = 0;
+
+	for (auto &e : column)
+		largest = max(largest, e.value);
+
+	//Never drop the largest entry, even if the column is very flat
+	float threshold = min((float)pruneThreshold, largest);
+
+	column.erase(remove_if(column.begin(), column.end(),
+		[threshold](const Entry &e) { return e.value < threshold; }), column.end());
+
+	if (column.size() > maxColumnEntries) {
+
+		nth_element(column.begin(), column.begin() + maxColumnEntries, column.end(),
+			[](const Entry &lhs, const Entry &rhs) {
+				return lhs.value > rhs.value || (lhs.value == rhs.value && lhs.row < rhs.row);
+			});
+
+		column.resize(maxColumnEntries);
+	}
+
+	//Inflate
+	double sum = 0;
+
+	for (auto &e : column) {
+		e.value = pow(e.value, inflation);
+		sum += e.value;
+	}
+
+	double maxValue = 0;
+	double sumSquares = 0;
+
+	for (auto &e : column) {
+		e.value /= sum;
+		maxValue = max(maxValue, (double)e.value);
+		sumSquares += (double)e.value * e.value;
+	}
+
+	return maxValue - sumSquares;
+}
+
+/*
+Build the starting matrix from the adjacency of the network.
+
+Column j holds the edges of genome j. Each column keeps only its
+maxNeighbors strongest edges and gets a self loop as strong as its
+strongest edge, then it is normalized so it sums to one.
+*/
+MarkovClustering::SparseMatrix MarkovClustering::buildMatrix(GenomeNetwork &net) {
+
+	net.buildAdjacency();
+
+	const vector<HomologyEdge> &edges = net.getEdges();
+
+	SparseMatrix matrix;
+	double chaos;
+
+	buildColumns(net.numNodes(), [&](unsigned int j, vector<Entry> &column, int) {
+
+		const unsigned int * neighbors;
+		const unsigned int * ranks;
+
+		size_t degree = net.getNeighbors(j, neighbors, ranks);
+
+		for (size_t k = 0; k < degree; ++k) {
+
+			float homology = edges[ranks[k]].homology;
+
+			if (neighbors[k] != j && homology > 0)
+				column.push_back({ neighbors[k], homology });
+		}
+
+		if (column.size() > maxNeighbors) {
+
+			nth_element(column.begin(), column.begin() + maxNeighbors, column.end(),
+				[](const Entry &lhs, const Entry &rhs) {
+					return lhs.value > rhs.value || (lhs.value == rhs.value && lhs.row < rhs.row);
+				});
+
+			column.resize(maxNeighbors);
+		}
+
+		float loop = 0;
+
+		for (auto &e : column)
+			loop = max(loop, e.value);
+
+		//Genomes without edges only flow to themselves
+		if (column.empty())
+			loop = 1;
+
+		column.push_back({ j, loop });
+
+		double sum = 0;
+
+		for (auto &e : column)
+			sum += e.value;
+
+		for (auto &e : column)
+			e.value /= sum;
+
+		return 0.0;
+
+	}, matrix.start, matrix.entries, chaos);
+
+	return matrix;
+}
+
+/*
+Do one expansion, pruning and inflation step.
+
+Column j of the squared matrix is the sum of the columns k of the
+matrix, weighted by entry (k, j). It is accumulated in a dense per
+thread array, and the rows that were touched are remembered so the
+array can be cleared again cheaply.
+*/
+double MarkovClustering::iterate(SparseMatrix &matrix) {
+
+	unsigned int n = matrix.start.size() - 1;
+
+	int threads = max(numThreads, 1);
+
+	vector<vector<float>> accumulators(threads);
+	vector<vector<unsigned int>> touched(threads);
+
+	SparseMatrix result;
+	double chaos;
+
+	buildColumns(n, [&](unsigned int j, vector<Entry> &column, int t) {
+
+		vector<float> &acc = accumulators[t];
+		vector<unsigned int> &rows = touched[t];
+
+		if (acc.empty())
+			acc.assign(n, 0);
+
+		rows.clear();
+
+		for (size_t a = matrix.start[j]; a < matrix.start[j + 1]; ++a) {
+
+			unsigned int k = matrix.entries[a].row;
+			float weight = matrix.entries[a].value;
+
+			for (size_t b = matrix.start[k]; b < matrix.start[k + 1]; ++b) {
+
+				unsigned int row = matrix.entries[b].row;
+
+				if (acc[row] == 0)
+					rows.push_back(row);
+
+				acc[row] += weight * matrix.entries[b].value;
+			}
+		}
+
+		for (unsigned int row : rows) {
+
+			//Products too small to represent never got a value
+			if (acc[row] > 0)
+				column.push_back({ row, acc[row] });
+
+			acc[row] = 0;
+		}
+
+		return pruneAndInflate(column);
+
+	}, result.start, result.entries, chaos);
+
+	matrix = move(result);
+
+	return chaos;
+}
+
+//Return the representative of x, halving the path on the way up
+static unsigned int findRoot(vector<unsigned int> &parent, unsigned int x) {
+
+	while (parent[x] != x) {
+		parent[x] = parent[parent[x]];
+		x = parent[x];
+	}
+
+	return x;
+}
+
+/*
+Run MCL on the network until it converges.
+
+Each genome is joined with the row its column sends the most flow to.
+Attractors that share flow end up joined as well, so every group of
+joined genomes is one family.
+*/
+vector<unsigned int> MarkovClustering::cluster(GenomeNetwork &net) {
+
+	unsigned int n = net.numNodes();
+
+	SparseMatrix matrix = buildMatrix(net);
+
+	converged = false;
+
+	for (iterations = 0; iterations < maxIterations;) {
+
+		double chaos = iterate(matrix);
+
+		++iterations;
+
+		cout << "MCL iteration " << iterations << ": " << matrix.entries.size()
+			<< " entries, chaos " << chaos << endl;
+
+		if (chaos < chaosLimit) {
+			converged = true;
+			break;
+		}
+	}
+
+	vector<unsigned int> parent(n);
+
+	iota(parent.begin(), parent.end(), 0);
+
+	for (unsigned int j = 0; j < n; ++j) {
+
+		unsigned int attractor = j;
+		float best = -1;
+
+		for (size_t a = matrix.start[j]; a < matrix.start[j + 1]; ++a) {
+
+			const Entry &e = matrix.entries[a];
+
+			if (e.value > best || (e.value == best && e.row < attractor)) {
+				best = e.value;
+				attractor = e.row;
+			}
+		}
+
+		unsigned int r1 = findRoot(parent, j);
+		unsigned int r2 = findRoot(parent, attractor);
+
+		if (r1 != r2)
+			parent[max(r1, r2)] = min(r1, r2);
+	}
+
+	vector<unsigned int> labels(n);
+
+	for (unsigned int j = 0; j < n; ++j)
+		labels[j] = findRoot(parent, j);
+
+	return labels;
+}
\ No newline at end of file
@@ -0,0 +1,122 @@
+/*
+Armon Azizi
+
+MarkovClustering.h
+
+This class clusters a GenomeNetwork with the Markov Cluster algorithm (MCL).
+
+The homology edges are turned into a column stochastic matrix, where
+column j holds the probability of a random walk stepping from genome j
+to each of its neighbors. The matrix is then repeatedly
+
+expanded: squared, so flow spreads along paths of length two,
+pruned: entries below a threshold are dropped and only the largest
+entries of each column are kept, so memory stays bounded,
+inflated: every entry is raised to a power and the column renormalized,
+which strengthens strong flow and weakens weak flow.
+
+Flow eventually collects in a few attractor genomes and every genome
+belongs to the family of the attractor its column flows to. The number
+of families comes out of the flow itself, the inflation power controls
+how fine grained they are.
+
+The matrix is stored column by column in compressed sparse form (CSR of
+the transposed matrix), and all three steps are done in parallel over
+columns. Convergence is measured while columns are inflated, so no
+extra pass over the matrix is needed.
+*/
+
+#ifndef MARKOVCLUSTERING_H
+#define MARKOVCLUSTERING_H
+
+#include "GenomeNetwork.h"
+
+#include <vector>
+#include <functional>
+
+using namespace std;
+
+class MarkovClustering {
+
+private:
+	//Nonzero entry of a column
+	struct Entry {
+		unsigned int row;
+		float value;
+	};
+
+	//Sparse matrix, column j is entries[start[j]] to entries[start[j + 1] - 1]
+	struct SparseMatrix {
+		vector<size_t> start;
+		vector<Entry> entries;
+	};
+
+	/*
+	Build a matrix column by column in parallel.
+
+	columnFn fills in a column and returns its chaos. The largest
+	chaos of all columns is stored in chaos.
+	*/
+	void buildColumns(unsigned int numColumns,
+		const function<double(unsigned int, vector<Entry> &, int)> &columnFn,
+		vector<size_t> &start, vector<Entry> &entries, double &chaos);
+
+	//Build the initial stochastic matrix from the edges of the network
+	SparseMatrix buildMatrix(GenomeNetwork &net);
+
+	//Expand, prune and inflate the matrix once. Return the largest column chaos.
+	double iterate(SparseMatrix &matrix);
+
+	//Keep the largest entries of a column, drop the rest, and inflate.
+	//Return the chaos of the column.
+	double pruneAndInflate(vector<Entry> &column);
+
+public:
+
+	MarkovClustering(double inflationPower, int threads);
+
+	~MarkovClustering();
+
+	//Power entries are raised to during inflation
+	double inflation;
+
+	/*
+	Number of strongest edges of every genome used to build the matrix.
+	Homology tables are complete graphs, where the many weak edges
+	would let flow leak between all families.
+	*/
+	unsigned int maxNeighbors;
+
+	//Entries smaller than this are removed after expansion
+	double pruneThreshold;
+
+	//Largest number of entries kept in a column
+	unsigned int maxColumnEntries;
+
+	//The matrix has converged when no column has a larger chaos than this
+	double chaosLimit;
+
+	//Stop after this many iterations even if not converged
+	int maxIterations;
+
+	//Number of threads to use
+	int numThreads;
+
+	//Number of iterations used by the last call to cluster()
+	int iterations;
+
+	//True if the last call to cluster() stopped because the chaos fell below chaosLimit
+	bool converged;
+
+	/*
+	Cluster the network.
+
+	Return the family label of every genome id. Genomes with the same
+	label are in the same family.
+	*/
+	vector<unsigned int> cluster(GenomeNetwork &net);
+
+};
+
+
+#endif // MARKOVCLUSTERING_H
\ No newline at end of file
@@ -0,0 +1,75 @@
+/*
+Armon Azizi
+
+Parallel.cpp
+
+A small helper for splitting a loop over threads.
+
+The range [0, count) is cut into blocks of grain items. Threads take
+the next free block from a shared counter until all blocks are done, so
+blocks that take longer than others don't leave the other threads idle.
+*/
+
+#include "Parallel.h"
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <functional>
+
+using namespace std;
+
+//One thread per core, or one thread if the number of cores is unknown.
+int defaultThreads() {
+
+	int cores = thread::hardware_concurrency();
+
+	return cores > 0 ? cores : 1;
+}
+
+//Run the body over all blocks of [0, count)
+void parallelFor(size_t count, size_t grain, int numThreads,
+	const function<void(size_t, size_t, int)> &body) {
+
+	if (grain == 0)
+		grain = 1;
+
+	size_t numBlocks = (count + grain - 1) / grain;
+
+	if (numThreads < 1)
+		numThreads = 1;
+
+	if ((size_t)numThreads > numBlocks)
+		numThreads = numBlocks;
+
+	atomic<size_t> nextBlock(0);
+
+	auto worker = [&](int t) {
+
+		size_t block;
+
+		while ((block = nextBlock.fetch_add(1)) < numBlocks) {
+
+			size_t begin = block * grain;
+			size_t end = begin + grain < count ? begin + grain : count;
+
+			body(begin, end, t);
+		}
+	};
+
+	//Nothing to split, run on the calling thread
+	if (numThreads <= 1) {
+		worker(0);
+		return;
+	}
+
+	vector<thread> threads;
+
+	for (int t = 1; t < numThreads; ++t)
+		threads.emplace_back(worker, t);
+
+	worker(0);
+
+	for (auto &t : threads)
+		t.join();
+}
\ No newline at end of file
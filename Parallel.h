@@ -0,0 +1,34 @@
+/*
+Armon Azizi
+
+Parallel.h
+
+A small helper for splitting a loop over threads.
+
+The range [0, count) is cut into blocks of grain items. Threads take
+the next free block from a shared counter until all blocks are done, so
+blocks that take longer than others don't leave the other threads idle.
+*/
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <functional>
+
+using namespace std;
+
+//Return the number of threads to use when the user didn't ask for a number
+int defaultThreads();
+
+/*
+Call body(begin, end, thread) for every block of [0, count) using numThreads threads.
+
+Every call covers exactly one block, so begin / grain is the block number.
+thread is a number between 0 and numThreads - 1 that can be used
+to index per thread scratch space.
+*/
+void parallelFor(size_t count, size_t grain, int numThreads,
+	const function<void(size_t, size_t, int)> &body);
+
+
+#endif // PARALLEL_H
\ No newline at end of file
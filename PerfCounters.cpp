@@ -0,0 +1,322 @@
+/*
+Armon Azizi
+
+PerfCounters.cpp
+
+This class reads the hardware performance counters of the CPU around the
+phases of a run, with the Linux perf_event_open system call.
+
+Every counter is read with the time it was enabled and the time it was
+actually counting, so counts can be scaled when the kernel had to take
+turns between more events than the CPU has counters.
+*/
+
+#include "PerfCounters.h"
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+using namespace std;
+
+//Names of the events, in the order of PerfEvent
+static const char * const EVENT_NAMES[NUM_PERF_EVENTS] = {
+	"cycles", "instructions", "LLC misses", "dTLB misses", "branch misses"
+};
+
+#ifdef __linux__
+
+//Set the type and config of the perf event that counts an event
+static void setEvent(int event, struct perf_event_attr &attr) {
+
+	//Cache events are a cache, an operation and a result, a byte each
+	auto readMisses = [](uint64_t cache) {
+		return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+	};
+
+	switch (event) {
+	case PERF_CYCLES:
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = PERF_COUNT_HW_CPU_CYCLES;
+		break;
+	case PERF_INSTRUCTIONS:
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+		break;
+	case PERF_LLC_MISSES:
+		attr.type = PERF_TYPE_HW_CACHE;
+		attr.config = readMisses(PERF_COUNT_HW_CACHE_LL);
+		break;
+	case PERF_DTLB_MISSES:
+		attr.type = PERF_TYPE_HW_CACHE;
+		attr.config = readMisses(PERF_COUNT_HW_CACHE_DTLB);
+		break;
+	default:
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+		break;
+	}
+}
+
+/*
+Open a counter of the event for this process and every thread it starts
+from now on. Return -1, with errno set, if it can't be opened.
+*/
+static int openCounter(int event) {
+
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+
+	attr.size = sizeof(attr);
+	setEvent(event, attr);
+
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	attr.inherit = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+
+	return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+#else
+
+//perf_event_open only exists on Linux
+static int openCounter(int) {
+	errno = ENOSYS;
+	return -1;
+}
+
+#endif
+
+/*
+Open a counter for every event. Events that can't be counted are
+left out, and the reasons are kept for the summary.
+*/
+PerfCounters::PerfCounters() : current(-1) {
+
+	for (int e = 0; e < NUM_PERF_EVENTS; ++e) {
+
+		fds[e] = openCounter(e);
+
+		if (fds[e] < 0) {
+
+			int reason = errno;
+
+			errors[e] = strerror(reason);
+
+			if (reason == EACCES || reason == EPERM)
+				errors[e] += " (see /proc/sys/kernel/perf_event_paranoid)";
+		}
+	}
+}
+
+//Return the events that aren't counted, grouped by why not
+string PerfCounters::unavailable() {
+
+	string text;
+
+	vector<bool> listed(NUM_PERF_EVENTS, false);
+
+	for (int e = 0; e < NUM_PERF_EVENTS; ++e) {
+
+		if (fds[e] >= 0 || listed[e]) continue;
+
+		if (!text.empty()) text += "; ";
+
+		for (int other = e; other < NUM_PERF_EVENTS; ++other) {
+			if (fds[other] < 0 && !listed[other] && errors[other] == errors[e]) {
+				text += (other == e ? "" : ", ") + string(EVENT_NAMES[other]);
+				listed[other] = true;
+			}
+		}
+
+		text += ": " + errors[e];
+	}
+
+	return text;
+}
+
+//Close the counters
+PerfCounters::~PerfCounters() {
+	for (int e = 0; e < NUM_PERF_EVENTS; ++e)
+		if (fds[e] >= 0)
+			close(fds[e]);
+}
+
+//Return true if at least one event is counted
+bool PerfCounters::isOpen() {
+
+	for (int e = 0; e < NUM_PERF_EVENTS; ++e)
+		if (fds[e] >= 0)
+			return true;
+
+	return false;
+}
+
+/*
+Read every counter. A counter that was only counting part of the time
+it was enabled is scaled up to the whole time.
+*/
+PerfReading PerfCounters::read() {
+
+	PerfReading reading;
+
+	for (int e = 0; e < NUM_PERF_EVENTS; ++e) {
+
+		reading.counts[e] = -1;
+
+		if (fds[e] < 0) continue;
+
+		//Value, time enabled, time running
+		uint64_t values[3];
+
+		if (::read(fds[e], values, sizeof(values)) != sizeof(values))
+			continue;
+
+		if (values[2] == 0)
+			reading.counts[e] = 0;
+		else if (values[2] < values[1])
+			reading.counts[e] = (double)values[0] * values[1] / values[2];
+		else
+			reading.counts[e] = values[0];
+	}
+
+	return reading;
+}
+
+//Return 0 for every counted event and -1 for the others
+PerfReading PerfCounters::zero() {
+
+	PerfReading reading;
+
+	for (int e = 0; e < NUM_PERF_EVENTS; ++e)
+		reading.counts[e] = fds[e] >= 0 ? 0 : -1;
+
+	return reading;
+}
+
+//Begin a phase with the given name, ending the current one first
+void PerfCounters::begin(const string &phase) {
+
+	if (current >= 0)
+		end();
+
+	current = 0;
+
+	while (current < (int)phaseNames.size() && phaseNames[current] != phase)
+		++current;
+
+	if (current == (int)phaseNames.size()) {
+		phaseNames.push_back(phase);
+		phaseRuns.push_back(0);
+		phaseTotals.push_back(zero());
+	}
+
+	phaseStart = read();
+}
+
+//End the current phase, add its counts to the totals of its name and return them
+PerfReading PerfCounters::end() {
+
+	PerfReading now = read();
+	PerfReading counts;
+
+	for (int e = 0; e < NUM_PERF_EVENTS; ++e) {
+
+		if (current < 0 || now.counts[e] < 0 || phaseStart.counts[e] < 0 || phaseTotals[current].counts[e] < 0) {
+			counts.counts[e] = -1;
+			continue;
+		}
+
+		//A scaled count can come out just below the last one
+		counts.counts[e] = max(0.0, now.counts[e] - phaseStart.counts[e]);
+		phaseTotals[current].counts[e] += counts.counts[e];
+	}
+
+	if (current >= 0)
+		++phaseRuns[current];
+
+	current = -1;
+
+	return counts;
+}
+
+//Return the totals of every run of a phase, 0 if it never ran
+PerfReading PerfCounters::total(const string &phase) {
+
+	for (size_t p = 0; p < phaseNames.size(); ++p)
+		if (phaseNames[p] == phase)
+			return phaseTotals[p];
+
+	return zero();
+}
+
+//Return the counts divided by divisor, unavailable events stay unavailable
+PerfReading PerfCounters::perUnit(const PerfReading &counts, double divisor) {
+
+	PerfReading result = counts;
+
+	for (int e = 0; e < NUM_PERF_EVENTS; ++e)
+		if (result.counts[e] >= 0 && divisor > 0)
+			result.counts[e] /= divisor;
+
+	return result;
+}
+
+//Return the counts on a single line, with n/a for events that aren't counted
+string PerfCounters::describe(const PerfReading &counts) {
+
+	ostringstream line;
+
+	line << fixed << setprecision(0);
+
+	for (int e = 0; e < NUM_PERF_EVENTS; ++e) {
+
+		if (e > 0) line << ", ";
+
+		line << EVENT_NAMES[e] << " ";
+
+		if (counts.counts[e] < 0)
+			line << "n/a";
+		else
+			line << counts.counts[e];
+
+		if (e == PERF_INSTRUCTIONS && counts.counts[PERF_CYCLES] > 0 && counts.counts[e] >= 0)
+			line << setprecision(2) << " (" << counts.counts[e] / counts.counts[PERF_CYCLES]
+				<< " per cycle)" << setprecision(0);
+	}
+
+	return line.str();
+}
+
+//Print the totals of every phase, or why no events are counted
+void PerfCounters::printSummary() {
+
+	if (!isOpen()) {
+		cout << "Hardware counters unavailable: " << unavailable() << endl;
+		return;
+	}
+
+	cout << "Hardware counters:" << endl;
+
+	for (size_t p = 0; p < phaseNames.size(); ++p)
+		cout << "  " << phaseNames[p] << " (" << phaseRuns[p] << (phaseRuns[p] == 1 ? " run" : " runs")
+			<< "): " << describe(phaseTotals[p]) << endl;
+
+	string missing = unavailable();
+
+	if (!missing.empty())
+		cout << "  not counted: " << missing << endl;
+}
\ No newline at end of file
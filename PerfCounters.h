@@ -0,0 +1,110 @@
+/*
+Armon Azizi
+
+PerfCounters.h
+
+This class reads the hardware performance counters of the CPU around the
+phases of a run, with the Linux perf_event_open system call.
+
+Five events are counted: cycles, instructions, last level cache misses,
+data TLB misses and mispredicted branches. Each one is opened as its own
+counter for user space only, and is inherited by every thread started
+after it was opened. The counts of a worker thread are added to the
+counter when the thread exits, so a phase that joins its threads before
+it ends sees all of their work.
+
+The counters run from the moment they are opened. A phase reads them
+when it begins and when it ends, and the difference is added to the
+totals of its name. When the CPU has fewer counters than events, the
+kernel takes turns counting them, and each count is scaled up by the
+share of the time its event was counted.
+
+Counters that can't be opened, because the kernel doesn't allow it or
+the CPU (or the virtual machine) doesn't have the event, are reported as
+unavailable, and the run goes on without them.
+*/
+
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//The events that are counted
+enum PerfEvent {
+	PERF_CYCLES,
+	PERF_INSTRUCTIONS,
+	PERF_LLC_MISSES,
+	PERF_DTLB_MISSES,
+	PERF_BRANCH_MISSES,
+	NUM_PERF_EVENTS
+};
+
+//Counts of every event, below 0 for events that aren't available
+struct PerfReading {
+	double counts[NUM_PERF_EVENTS];
+};
+
+class PerfCounters {
+
+private:
+	//File descriptor of the counter of every event, -1 if it couldn't be opened
+	int fds[NUM_PERF_EVENTS];
+
+	//Why the events that couldn't be opened aren't available
+	string errors[NUM_PERF_EVENTS];
+
+	//Phases in the order they first began, how often they ran and their counts
+	vector<string> phaseNames;
+	vector<size_t> phaseRuns;
+	vector<PerfReading> phaseTotals;
+
+	//Phase that has begun and not ended, -1 if there is none, and the reading at its start
+	int current;
+	PerfReading phaseStart;
+
+	//Return 0 for every counted event and -1 for the others
+	PerfReading zero();
+
+	//Return the events that aren't counted, grouped by why not
+	string unavailable();
+
+public:
+
+	//Open the counters
+	PerfCounters();
+
+	~PerfCounters();
+
+	PerfCounters(const PerfCounters &) = delete;
+	PerfCounters& operator=(const PerfCounters &) = delete;
+
+	//Return true if at least one event is counted
+	bool isOpen();
+
+	//Return the counts since the counters were opened
+	PerfReading read();
+
+	//Begin a phase with the given name, ending the current one first
+	void begin(const string &phase);
+
+	//End the current phase, add its counts to the totals of its name and return them
+	PerfReading end();
+
+	//Return the totals of every run of a phase, 0 if it never ran
+	PerfReading total(const string &phase);
+
+	//Return the counts divided by divisor
+	static PerfReading perUnit(const PerfReading &counts, double divisor);
+
+	//Return the counts on a single line, with the instructions per cycle
+	static string describe(const PerfReading &counts);
+
+	//Print the totals of every phase, or why no events are counted
+	void printSummary();
+};
+
+
+#endif // PERFCOUNTERS_H
\ No newline at end of file
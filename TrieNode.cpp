@@ -16,9 +16,6 @@ using namespace std;
 
 TrieNode::TrieNode() {
 
-	//declare the nucleotide vector
-	nucleotides = vector<TrieNode *>(4);
-
 	//instantiate all pointers to null
 	for (int i = 0; i < 4; ++i)
 		nucleotides[i] = nullptr;
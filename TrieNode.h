@@ -25,7 +25,8 @@ public:
 	~TrieNode();
 
 	//Stores 4 children, one fore each nucleotide.
-	vector<TrieNode *> nucleotides;
+	//Kept inside the node so a lookup reaches a child with a single load.
+	TrieNode * nucleotides[4];
 
 };
 
@@ -0,0 +1,138 @@
+/*
+Armon Azizi
+
+classifygenome.cpp
+
+This program places new genomes into the families found by findfamilies.
+
+Instead of comparing a new genome to every genome in the families, the
+sequences of all members of a family are merged into one index, tagged
+with the number of members that contain them. Each new genome is read
+once and every one of its sequences is looked up in the merged index,
+which gives its containment in every family at the same time.
+
+The program takes input in the following way:
+
+./classifygenome families_file sequence_length query.fasta [more queries] [options]
+
+where:
+
+families_file is the output of findfamilies, where every genome is the
+path to its fasta file, as genomecompare names them.
+
+sequence_length is the same as for genomecompare, at most 32.
+
+options are:
+
+--threads N          number of threads used to build the index
+                     (default: number of cores)
+
+For every query the best family is printed, followed by every family
+in order of containment:
+
+QUERY<TAB>BEST_FAMILY<TAB>CONTAINMENT_PERCENT
+<TAB>FAMILY<TAB>CONTAINMENT_PERCENT<TAB>MEMBER_SUPPORT_PERCENT<TAB>MEMBERS
+
+where containment is the percentage of the query's sequences found in
+any member of the family, and member support is the percentage found in
+an average member.
+
+*/
+
+#include "FamilyIndex.h"
+#include "FamilyClustering.h"
+#include "KmerScanner.h"
+#include "Parallel.h"
+
+#include <string>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <iostream>
+#include <chrono>
+
+using namespace std;
+
+int main(int argc, char** argv) {
+
+	if (argc < 4) {
+		cout << "usage: ./classifygenome families_file sequence_length query.fasta "
+			<< "[more queries] [--threads N]" << endl;
+		return -1;
+	}
+
+	string families_file = argv[1];
+	int seq_len = atoi(argv[2]);
+	int num_threads = defaultThreads();
+
+	vector<string> queries;
+
+	for (int i = 3; i < argc; ++i) {
+
+		if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+			num_threads = atoi(argv[++i]);
+		else
+			queries.push_back(argv[i]);
+	}
+
+	if (seq_len < 1 || seq_len > MAX_PACKED_LENGTH) {
+		cout << "sequence_length must be between 1 and " << MAX_PACKED_LENGTH << endl;
+		return -1;
+	}
+
+	vector<pair<string, vector<string>>> families = readFamilies(families_file);
+
+	if (families.empty()) {
+		cout << "no families in " << families_file << endl;
+		return -1;
+	}
+
+	auto start = chrono::steady_clock::now();
+
+	FamilyIndex index(seq_len, num_threads);
+
+	string unreadable;
+
+	if (!index.build(families, unreadable)) {
+		cout << "could not read " << unreadable << endl;
+		return -1;
+	}
+
+	chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+	cerr << "Indexed " << index.numSequences() << " sequences of " << index.numFamilies()
+		<< " families in " << elapsed.count() << "s" << endl;
+
+	int status = 0;
+
+	for (auto &query : queries) {
+
+		vector<double> containment, support;
+
+		int best = index.classify(query, containment, support);
+
+		if (best == -1) {
+			cout << "could not read " << query << endl;
+			status = -1;
+			continue;
+		}
+
+		cout << query << '\t' << index.getFamilyName(best) << '\t'
+			<< to_string(containment[best] * 100) << endl;
+
+		//Families in order of containment
+		vector<unsigned int> order(index.numFamilies());
+		iota(order.begin(), order.end(), 0);
+
+		stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) {
+			return containment[a] > containment[b];
+		});
+
+		for (unsigned int f : order)
+			cout << '\t' << index.getFamilyName(f) << '\t' << to_string(containment[f] * 100)
+				<< '\t' << to_string(support[f] * 100) << '\t' << index.getFamilySize(f) << endl;
+	}
+
+	return status;
+}
\ No newline at end of file
@@ -0,0 +1,162 @@
+/*
+Armon Azizi
+
+clusterpipeline.cpp
+
+This program runs genomecompare and findfamilies in one process.
+
+The homologies calculated by the comparison are handed straight to the
+genome network, instead of being written to a text file and parsed
+back in. The families are written in the same format as findfamilies.
+
+The program takes input in the following way:
+
+./clusterpipeline genome_directory file_names out_file sequence_length [num_clusters] [options]
+
+where:
+
+genome_directory, file_names and sequence_length are the same as for
+genomecompare.
+
+out_file is the file the families are written to.
+
+num_clusters is the final number of families, as for findfamilies.
+
+options are the clustering options of findfamilies, and:
+
+--table FILE         also write the homology table to FILE, in the
+                     format genomecompare writes it
+--mem-limit SIZE     memory the genome indexes may use at once, as for
+                     genomecompare
+--tolerance T        sample homologies to within T percentage points, as
+                     for genomecompare
+--seed S             seed of the sampling order, as for genomecompare
+--min-homology H     only add pairs with at least H percent homology to
+                     the network, as for genomecompare
+--top-k K            only add each genome's K most homologous pairs, as
+                     for genomecompare
+
+*/
+
+#include "GenomeComparison.h"
+#include "GenomeNetwork.h"
+#include "FamilyClustering.h"
+#include "KmerScanner.h"
+
+#include <string>
+#include <cstring>
+#include <memory>
+#include <iostream>
+
+using namespace std;
+
+/*
+Compare all genomes, build the network from the homologies in memory,
+cluster it and write the families.
+*/
+int main(int argc, char** argv) {
+
+	if (argc < 5) {
+		cout << "usage: ./clusterpipeline genome_directory file_names out_file "
+			<< "sequence_length [num_clusters] [options]" << endl;
+		printClusterOptions();
+		cout << "  --table FILE                 also write the homology table to FILE" << endl;
+		printCompareOptions();
+		return -1;
+	}
+
+	string genome_directory = argv[1];
+	string file_names = argv[2];
+	string out_file = argv[3];
+	int sequence_length = atoi(argv[4]);
+
+	if (sequence_length < 1) {
+		cout << "sequence length must be at least 1" << endl;
+		return -1;
+	}
+
+	ClusterOptions options;
+	string table_file = "";
+	CompareOptions compareOptions;
+
+	//Read number of clusters and optional arguments
+	for (int i = 5; i < argc; ++i) {
+
+		if (parseClusterOption(argc, argv, i, options) || parseCompareOption(argc, argv, i, compareOptions))
+			continue;
+
+		if (!strcmp(argv[i], "--table") && i + 1 < argc)
+			table_file = argv[++i];
+		else if (argv[i][0] != '-' && options.numClusters == 0)
+			options.numClusters = atoi(argv[i]);
+		else {
+			cout << "unknown option " << argv[i] << endl;
+			return -1;
+		}
+	}
+
+	if (!checkClusterOptions(options))
+		return -1;
+
+	//The same threads compare and cluster
+	compareOptions.numThreads = options.numThreads;
+
+	bool sampling = compareOptions.tolerance > 0;
+
+	if (sampling && sequence_length > MAX_PACKED_LENGTH) {
+		cout << "sequence length must be at most " << MAX_PACKED_LENGTH << " when sampling" << endl;
+		return -1;
+	}
+
+	cout << "getting file names" << endl;
+
+	//Get all genome fasta file paths
+	vector<string> files = getFileNames(genome_directory, file_names);
+
+	//Build the network while the genomes are compared
+	GenomeNetwork geneNet;
+
+	vector<unsigned int> ids;
+
+	for (auto &file : files)
+		ids.push_back(geneNet.intern(file));
+
+	//With a top K only about K edges per genome are added
+	if (compareOptions.topK > 0)
+		geneNet.reserveEdges(files.size() * compareOptions.topK);
+	else
+		geneNet.reserveEdges(files.size() * (files.size() - 1) / 2);
+
+	unique_ptr<HomologyWriter> writer;
+
+	if (table_file != "")
+		writer.reset(new HomologyWriter(table_file, files, sampling));
+
+	//Compare every genome to every other genome, adding each pair as soon as it is finished
+	compareGenomes(files, sequence_length, compareOptions,
+		[&](unsigned int i, unsigned int j, double percent, double precision) {
+
+			geneNet.addEdge(ids[i], ids[j], percent);
+
+			if (writer)
+				writer->write(i, j, percent, precision);
+		});
+
+	if (writer) {
+		writer.reset();
+		cout << "homology table written to " << table_file << endl;
+	}
+
+	if (!findFamilies(geneNet, options))
+		return -1;
+
+	//get list of families
+	auto families = geneNet.getFamilyVector();
+
+	cout << families.size() << " families found" << endl;
+
+	//write families to file
+	writeFile(out_file, families);
+
+	cout << "Clusters calculated and output to file!" << endl;
+}
\ No newline at end of file
@@ -18,7 +18,8 @@ related genomes for each family.
 
 The program takes input in the following way:
 
-./findfamilies input_file.txt output_file.txt num_clusters
+./findfamilies input_file.txt output_file.txt num_clusters [options]
+./findfamilies input_file.txt output_file.txt --method mcl [options]
 
 where:
 
@@ -31,113 +32,154 @@ staph	strep	32.2376
 
 output_file is the file to write to
 
-and num_clusters is the final number of families.
+and num_clusters is the final number of families. It is not needed
+with --method mcl, where the number of families follows from the data.
+
+options are:
+
+--method M           clustering method, one of
+                     single: trim the least homologous edges until there
+                             are num_clusters families (default)
+                     average: join the families with the highest
+                             average homology until there are
+                             num_clusters families (UPGMA)
+                     mcl:    Markov clustering, families are the
+                             attractors of a random walk on the network
+--inflation R        MCL inflation power above 1, larger values give
+                     smaller families (default: 2.0)
+--neighbors K        MCL only follows the K most homologous edges of
+                     every genome, at least 1 (default: 20)
+--threads N          number of threads used to read the input and to
+                     find clusters (default: number of cores)
+--min-homology H     ignore all edges with a homology below H percent.
+                     Genomes with only weaker edges get a family of
+                     their own.
+--mem-limit SIZE     cluster with single linkage without loading the
+                     network, sorting at most SIZE of edges in memory at
+                     once, such as 512M or 16G. The rest are kept in
+                     temporary files next to output_file. The families
+                     are the same as without the limit.
+--perf               read the hardware performance counters (cycles,
+                     instructions, cache, TLB and branch misses) around
+                     reading, clustering and writing, and print them at
+                     the end. Without counters the run goes on as usual.
 
 */
 
 #include "GenomeNetwork.h"
-#include "GenomeNode.h"
+#include "HomologyParser.h"
+#include "FamilyClustering.h"
+#include "ExternalClustering.h"
+#include "GenomeComparison.h"
+#include "PerfCounters.h"
 
 #include <string>
-#include <sstream>
+#include <cstring>
+#include <cmath>
+#include <memory>
 #include <iostream>
-#include <fstream>
 
 using namespace std;
 
-//Build the graph reading input line by line
-void buildGraph(string fileName, GenomeNetwork &net) {
-
-	ifstream in(fileName);
-
-	string gen1;
-	string gen2;
-	double homology;
-
-	string line;
-
-	//skip header
-	getline(in, line);
-
-	//Read every line
-	while (in) {
-
-		getline(in, line);
+int main(int argc, char** argv) {
 
-		if (line == "")
-			break;
+	if (argc < 3) {
+		cout << "usage: ./findfamilies input_file output_file [num_clusters] [options]" << endl;
+		printClusterOptions();
+		cout << "  --min-homology H             ignore edges below H percent" << endl;
+		cout << "  --mem-limit SIZE             sort edges on disk, using at most SIZE of memory for them" << endl;
+		cout << "  --perf                       report hardware performance counters of every phase" << endl;
+		return -1;
+	}
 
-		istringstream s(line);
+	string in_file = argv[1];
+	string out_file = argv[2];
 
-		string tempHom;
-		
-		//parse line into genomes and homology
-		getline(s, gen1, '\t');
-		getline(s, gen2, '\t');
-		getline(s, tempHom, '\t');
+	ClusterOptions options;
+	double min_homology = -HUGE_VAL;
+	size_t mem_limit = 0;
+	bool perf_counters = false;
+
+	//Read number of clusters and optional arguments
+	for (int i = 3; i < argc; ++i) {
+
+		if (parseClusterOption(argc, argv, i, options))
+			continue;
+
+		if (!strcmp(argv[i], "--min-homology") && i + 1 < argc)
+			min_homology = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--mem-limit") && i + 1 < argc && parseMemorySize(argv[i + 1], mem_limit))
+			++i;
+		else if (!strcmp(argv[i], "--perf"))
+			perf_counters = true;
+		else if (argv[i][0] != '-' && options.numClusters == 0)
+			options.numClusters = atoi(argv[i]);
+		else {
+			cout << "unknown option " << argv[i] << endl;
+			return -1;
+		}
+	}
 
-		homology = atof(tempHom.c_str());
+	if (!checkClusterOptions(options))
+		return -1;
 
-		//Add set of nodes to network
-		net.addSet(gen1, gen2, homology);
+	//Hardware counters around every phase, only when asked for
+	unique_ptr<PerfCounters> perf;
 
-		//Add homology edge to network
-		net.addHomology(homology, gen1, gen2);
+	if (perf_counters)
+		perf.reset(new PerfCounters());
 
-	}
-}
+	GenomeNetwork geneNet;
 
-//Write all families to the output file
-void writeFile(string outFile, vector<pair<string, vector<GenomeNode *>>> families) {
+	//Cluster from edges sorted on disk
+	if (mem_limit > 0) {
 
-	ofstream out(outFile);
+		if (options.method != "single") {
+			cout << "--mem-limit only works with --method single" << endl;
+			return -1;
+		}
 
-	for (auto i : families) {
+		cout << "Finding families from edges sorted on disk" << endl;
 
-		//Write family name
-		out << i.first << endl;
-		out.flush();
+		ExternalClustering external(mem_limit, out_file + ".run");
 
-		//Write all species in the family
-		for (auto j : i.second) {
-			out << j->name << endl;
-			out.flush();
-		}
+		if (perf) perf->begin("sort and cluster");
 
-		out << endl;
-		out.flush();
+		if (!external.cluster(in_file, geneNet, options.numClusters, min_homology))
+			return -1;
 
+		cout << external.appliedEdges << " of " << external.numEdges << " edges joined families" << endl;
 	}
+	else {
 
-	out.close();
-}
+		//Build the network
+		cout << "Building Network" << endl;
 
-int main(int argc, char** argv) {
-
-	string in_file = argv[1];
-	string out_file = argv[2];
-	int num_clusters = atoi(argv[3]);
+		if (perf) perf->begin("read");
 
-	GenomeNetwork geneNet;
+		if (!parseHomologies(in_file, geneNet, min_homology, options.numThreads))
+			return -1;
 
-	//Build the network
-	cout << "Building Network" << endl;
-	buildGraph(in_file, geneNet);
+		if (perf) perf->begin("cluster");
 
-	if (num_clusters > geneNet.numNodes()) {
-		cout << "number of clusters must be smaller than number of nodes!" << endl;
-		return -1;
+		if (!findFamilies(geneNet, options))
+			return -1;
 	}
 
-	//Find num_clusters families in the network
-	cout << "Finding families" << endl;
-	geneNet.cluster(num_clusters);
-
 	//get list of families
 	auto families = geneNet.getFamilyVector();
 
+	cout << families.size() << " families found" << endl;
+
 	//write families to file
+	if (perf) perf->begin("write");
+
 	writeFile(out_file, families);
 
+	if (perf) {
+		perf->end();
+		perf->printSummary();
+	}
+
 	cout << "Clusters calculated and output to file!" << endl;
 }
\ No newline at end of file
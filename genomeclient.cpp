@@ -0,0 +1,84 @@
+/*
+Armon Azizi
+
+genomeclient.cpp
+
+This program sends a request to genomeserver and prints the answer.
+
+The program takes input in the following way:
+
+./genomeclient socket_path COMPARE genome.fasta
+./genomeclient socket_path FAMILY genome.fasta
+./genomeclient socket_path CLASSIFY genome.fasta
+./genomeclient socket_path SHUTDOWN
+
+where socket_path is the socket genomeserver is listening on.
+The genome path is made absolute before it is sent, since the server
+may run in a different directory.
+
+*/
+
+#include "LocalSocket.h"
+
+#include <string>
+#include <iostream>
+#include <climits>
+#include <cstdlib>
+#include <unistd.h>
+
+using namespace std;
+
+int main(int argc, char** argv) {
+
+	if (argc < 3) {
+		cout << "usage: ./genomeclient socket_path COMPARE|FAMILY|CLASSIFY genome.fasta" << endl;
+		cout << "       ./genomeclient socket_path SHUTDOWN" << endl;
+		return -1;
+	}
+
+	string socket_path = argv[1];
+	string request = argv[2];
+
+	if (argc > 3) {
+
+		char path[PATH_MAX];
+
+		if (!realpath(argv[3], path)) {
+			cout << "could not find " << argv[3] << endl;
+			return -1;
+		}
+
+		request += ' ';
+		request += path;
+	}
+
+	int fd = connectLocal(socket_path);
+
+	if (fd < 0) {
+		cout << "could not connect to " << socket_path << endl;
+		return -1;
+	}
+
+	writeAll(fd, request + '\n');
+
+	//Print the answer until the server closes the connection
+	char buffer[4096];
+	ssize_t n;
+
+	bool error = false;
+	bool first = true;
+
+	while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+
+		if (first && string(buffer, n).compare(0, 5, "ERROR") == 0)
+			error = true;
+
+		first = false;
+
+		cout.write(buffer, n);
+	}
+
+	close(fd);
+
+	return error ? -1 : 0;
+}
\ No newline at end of file
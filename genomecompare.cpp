@@ -21,7 +21,7 @@ the average of the two genomes is the total homology between them.
 
 The program takes input in the following way:
 
-./genomecompare genome_directory file_names out_file sequence_length
+./genomecompare genome_directory file_names out_file sequence_length [options]
 
 where:
 
@@ -38,6 +38,12 @@ genome1<TAB>genome2<TAB>%homology
 genome1<TAB>genome3<TAB>%homology
 ...
 
+followed by a column with the precision of each homology when sampling
+with --tolerance.
+
+Each pair is written as soon as both of its directions are known, so
+the lines are in order of the second genome of each pair.
+
 sequence_length is the length of sequences to compare
 when determining the homology between genomes.
 naturally, a longer sequence length will result in a
@@ -45,235 +51,154 @@ smaller percentage of mapped reads. But, the length remains constant
 for all genomes and yields relative homologies between genomes
 that are somewhat accurate.
 
+sequence_length can also be a comma separated list, such as 8,10,12,14,16,
+to compare at several lengths in a single run. Every genome is then read
+once for all lengths, and one table is written per length, with .k<length>
+added before the extension of out_file (out.k8.txt, out.k10.txt, ...).
+Lists are limited to lengths of at most 32.
+
+options are:
+
+--mem-limit SIZE     memory the genome indexes may use at once, such as
+                     512M or 16G (default: one genome at a time). As many
+                     genomes as fit are indexed together, and every other
+                     genome is read once for all of them instead of once
+                     per index.
+--tolerance T        estimate every homology from a random sample of
+                     sequences, until it is known to within T percentage
+                     points at a nominal 95% confidence (default: search
+                     for all of them). T must be above 0. The table then
+                     gets a fourth column with the precision reached for
+                     each pair. Limited to lengths of at most 32.
+--seed S             seed of the sampling order (default: 1). The same
+                     seed gives the same table.
+--min-homology H     only write pairs with at least H percent homology.
+--threads N          number of threads that read and search a genome
+                     together (default: number of cores). Each genome is
+                     cut into pieces at line starts, and the counts of
+                     all pieces add up to the same homologies as one
+                     thread. Only used with a single sequence length.
+--top-k K            only write the pairs that are among the K most
+                     homologous pairs of either of their genomes, so the
+                     table has at most N * K lines instead of N^2 / 2.
+                     These are written once all genomes are compared.
+--perf               read the hardware performance counters (cycles,
+                     instructions, cache, TLB and branch misses) around
+                     every phase and every genome read, and print them
+                     with the run summary. Without counters the run goes
+                     on as usual.
+
 
 */
 
-#include "GenomeTrie.h"
+#include "GenomeComparison.h"
+
+#include "KmerScanner.h"
 
 #include <string>
+#include <cstring>
+#include <vector>
+#include <memory>
 #include <sstream>
-#include <iostream>
-#include <fstream>
 #include <algorithm>
+#include <iostream>
 
 using namespace std;
 
 /*
-given a path to a fasta file containing a genome, build a 
-GenomeTrie that contains all of its sequences. The trie will only
-contain sequences of length seqLen.
+Get file names, then for each genome, build a trie and 
+compare all other genomes to it. Calculate all homologies and
+write them to the output file.
 */
-void buildTrie(string fileName, GenomeTrie &trie, int seqLen) {
-
-	//Read fasta file
-	ifstream infile(fileName);
-	
-	string tempSequence = "";
-
-	//read file line by line, and parse in into the correct length sequences.
-	while (infile) {
-
-		string s;
-
-		// get the next line
-		if (!getline(infile, s)) break;
-		
-		//skip fasta header lines
-		if (s[0] == '>') continue;
-
-		//Add current sequence to temp
-		tempSequence += s;
-
-		//If the temp is shorter than the length we want, read another line.
-		if (tempSequence.size() < seqLen) continue;
-
-		//While the temp is longer than the sequence we want,
-		//remove sequence from front of temp and add it to the trie.
-		while (tempSequence.size() > seqLen) {
-			
-			string newSeq = tempSequence.substr(0, seqLen);
-			
-			trie.addSequence(newSeq);
-			
-			tempSequence = tempSequence.substr(1);
-		}
+int main(int argc, char** argv) {
 
+	if (argc < 5) {
+		cout << "usage: ./genomecompare genome_directory file_names out_file "
+			<< "sequence_length[,sequence_length...] [options]" << endl;
+		printCompareOptions();
+		cout << "  --threads N                  number of threads (default: number of cores)" << endl;
+		return -1;
 	}
 
-	infile.close();
-
-}
-
-/*
-Given a built genometrie and a path to a fasta file of the genome
-that we want to map to the trie, return the proportion of mapped reads
-contained in the genome of the given length.
-*/
-double getMappedPercentage(string fileName, GenomeTrie &trie, int seqLen) {
-
-	double numMappedReads = 0;
-	double totalReads = 0;
-
-
-	ifstream infile(fileName);
-
-	string tempSequence = "";
-
-	//Read file line by line.
-	while (infile) {
-
-		string s;
-
-		// get the next line
-		if (!getline(infile, s)) break;
-
-
-		//skip fasta header lines
-		if (s[0] == '>') continue;
-
-
-		tempSequence += s;
-
-		if (tempSequence.size() < seqLen) continue;
-
-		//Read next sequence and seqch for it in the trie.
-		while (tempSequence.size() > seqLen) {
-
-			string newSeq = tempSequence.substr(0, seqLen);
+	string genome_directory = argv[1];
+	string file_names = argv[2];
+	string out_file = argv[3];
 
-			if (trie.containsSequence(newSeq))
-				++numMappedReads;
+	//Read the list of sequence lengths
+	vector<int> sequence_lengths;
 
-			++totalReads;
+	stringstream lengths(argv[4]);
+	string length;
 
-			tempSequence = tempSequence.substr(seqLen);
+	while (getline(lengths, length, ',')) {
 
-		}
+		int k = atoi(length.c_str());
 
+		if (find(sequence_lengths.begin(), sequence_lengths.end(), k) == sequence_lengths.end())
+			sequence_lengths.push_back(k);
 	}
 
-	//return the number of mapped reads over the number of reads searched for in the trie.
-	return (double)(numMappedReads / totalReads);
-
-	infile.close();
-
-}
-
-/*
-Given a path to the directory that all of the files are stored in and the
-titla of a file that contains all of the fasta file titles,
-return a vector of strings that contains the path to each fasta file.
-*/
-vector<string> getFileNames(string genome_directory, string file_names) {
-	
-	vector <string> result;
-
-	ifstream infile(file_names);
-
-	//Read title file line by line
-	while (infile) {
-
-		string s;
-
-		// get the next line
-		if (!getline(infile, s)) break;
-
-		//Strip newline character from file title
-		//s.erase(s.find_last_not_of("\n") + 1);
-		s.pop_back();
-
-		if (s == "") break;
-
-		//new complete path to file.
-		string newName = genome_directory + '/' + s;
-
-		result.push_back(newName);
+	if (sequence_lengths.empty()) {
+		cout << "at least one sequence length must be given" << endl;
+		return -1;
 	}
 
-	return result;
-}
+	bool multiple = sequence_lengths.size() > 1;
 
-/*
-Writes all of the values in a matrix of proportions to the given out file.
-*/
-void writeValues(string out, vector<string> files, vector<vector<double>> values) {
-
-	ofstream outFile(out);
-
-	int numFiles = files.size();
+	for (int k : sequence_lengths) {
 
-	//Write Header
-	outFile << "Genome1\tGenome2\tHomology Percent" << endl;
+		if (k < 1) {
+			cout << "sequence length must be at least 1" << endl;
+			return -1;
+		}
 
-	//visit each location in matrix and write 
-	//values to file.
-	for (int i = 0; i < numFiles; ++i) {
+		if (multiple && k > MAX_PACKED_LENGTH) {
+			cout << "sequence lengths must be at most " << MAX_PACKED_LENGTH
+				<< " when comparing at several lengths" << endl;
+			return -1;
+		}
+	}
 
-		for (int j = i + 1; j < files.size(); ++j) {
+	CompareOptions options;
 
-			double percent = ((values[i][j] + values[j][i]) / 2) * 100;
+	for (int i = 5; i < argc; ++i) {
 
-			string newLine = files[i] + '\t' + files[j] + '\t' + to_string(percent);
+		if (parseCompareOption(argc, argv, i, options))
+			continue;
 
-			outFile << newLine << endl;
-			outFile.flush();
+		if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+			options.numThreads = atoi(argv[++i]);
+		else {
+			cout << "unknown option " << argv[i] << endl;
+			return -1;
 		}
-
 	}
 
-	outFile.close();
+	bool sampling = options.tolerance > 0;
 
-}
-
-/*
-Get file names, then for each genome, build a trie and 
-compare all other genomes to it. Calculate all homologies and
-write them to the output file.
-*/
-int main(int argc, char** argv) {
-
-	string genome_directory = argv[1];
-	string file_names = argv[2];
-	string out_file = argv[3];
-	int sequence_length = atoi(argv[4]);
+	if (sampling && *max_element(sequence_lengths.begin(), sequence_lengths.end()) > MAX_PACKED_LENGTH) {
+		cout << "sequence lengths must be at most " << MAX_PACKED_LENGTH << " when sampling" << endl;
+		return -1;
+	}
 
 	cout << "getting file names" << endl;
 
 	//Get all genome fasta file paths
 	vector<string> files = getFileNames(genome_directory, file_names);
 
-	int numFiles = files.size();
-
-	//Create matrix to store all homology values
-	vector<vector<double>> values(numFiles, std::vector<double>(numFiles, 0));
-	
-	//Compare every genome to every other genome to determine homology.
-	for (unsigned int i = 0; i < files.size(); ++i) {
-
-		GenomeTrie trie;
-
-		string file1 = files[i];
-
-		//Build a trie for genome i
-		cout << "Building trie for :" << file1 << endl;
-		buildTrie(file1, trie, sequence_length);
+	//Compare every genome to every other genome to determine homology,
+	//writing each pair to the file as soon as it is finished.
+	vector<unique_ptr<HomologyWriter>> writers;
 
+	for (int k : sequence_lengths)
+		writers.emplace_back(new HomologyWriter(tableName(out_file, k, multiple), files, sampling));
 
-		for (unsigned int j = 0; j < files.size(); ++j) {
-
-			if (j != i) {
-				string file2 = files[j];
-
-				//Calculate homology between genome j and genome i
-				cout << "Calculating Homology For: " << file1 << " " << file2 << endl;
-				values[i][j] = getMappedPercentage(file2, trie, sequence_length);
-				cout << values[i][j] << endl;
-			}
-		}
-	}
+	compareGenomes(files, sequence_lengths, options,
+		[&](unsigned int l, unsigned int i, unsigned int j, double percent, double precision) {
+			writers[l]->write(i, j, percent, precision);
+		});
 
-	//Write homology values to the file.
-	writeValues(out_file, files, values);
+	writers.clear();
 
 	cout << "homology calculated and written to file" << endl;
 
@@ -0,0 +1,373 @@
+/*
+Armon Azizi
+
+genomeserver.cpp
+
+This program keeps the tries of a set of genomes in memory and answers
+questions about new genomes over a Unix domain socket, so a new genome
+can be placed without indexing the whole set again.
+
+At startup a trie is built for every genome, as genomecompare does,
+and the sequences genomecompare would search for in each genome are
+kept as well, so a genome can be mapped onto a new trie without reading
+its file again. The families found by findfamilies can be loaded so the
+server can say which family a new genome belongs to. With families loaded
+a merged index of every family's sequences is built as well, as
+classifygenome does.
+
+The program takes input in the following way:
+
+./genomeserver genome_directory file_names sequence_length socket_path [options]
+
+where:
+
+genome_directory, file_names and sequence_length are the same as for
+genomecompare.
+
+socket_path is the path of the socket file to listen on. An existing
+file there is only replaced if it is the socket of a server that has
+stopped.
+
+options are:
+
+--families FILE      families written by findfamilies for these genomes
+--threads N          number of threads (default: number of cores)
+
+Requests are single lines, answered by genomeclient:
+
+COMPARE genome.fasta    homology of the genome to every genome in the
+                        server, in the format genomecompare writes
+FAMILY genome.fasta     the family of the most homologous genome, that
+                        genome and its homology
+CLASSIFY genome.fasta   the containment of the genome in every family,
+                        in the format classifygenome writes
+SHUTDOWN                stop the server
+
+*/
+
+#include "GenomeComparison.h"
+#include "GenomeTrie.h"
+#include "FamilyClustering.h"
+#include "FamilyIndex.h"
+#include "KmerScanner.h"
+#include "LocalSocket.h"
+#include "Parallel.h"
+
+#include <string>
+#include <cstring>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <numeric>
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <csignal>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+
+using namespace std;
+
+//Seconds the server waits for a client to send its request or take its answer
+const int CLIENT_TIMEOUT = 30;
+
+//Everything the server keeps in memory
+struct ResidentGenomes {
+
+	//Path of every genome, as genomecompare names them
+	vector<string> files;
+
+	//Trie of every genome
+	vector<unique_ptr<GenomeTrie>> tries;
+
+	//Sequences genomecompare searches for in every genome
+	vector<string> sequences;
+
+	//Family of every genome, empty if unknown
+	vector<string> families;
+
+	//Merged sequences of every family, null if no families were loaded
+	unique_ptr<FamilyIndex> familyIndex;
+
+	int sequenceLength;
+
+	int numThreads;
+};
+
+//Build the trie and the query sequences of every genome in parallel
+void loadGenomes(ResidentGenomes &genomes) {
+
+	unsigned int n = genomes.files.size();
+
+	genomes.tries.resize(n);
+	genomes.sequences.resize(n);
+
+	parallelFor(n, 1, genomes.numThreads, [&](size_t begin, size_t end, int) {
+
+		for (size_t i = begin; i < end; ++i) {
+
+			genomes.tries[i].reset(new GenomeTrie());
+
+			buildTrie(genomes.files[i], *genomes.tries[i], genomes.sequenceLength);
+
+			genomes.sequences[i] = getQuerySequences(genomes.files[i], genomes.sequenceLength);
+		}
+	});
+}
+
+/*
+Return the homology percentage of the query genome to every resident genome.
+
+The query is read once: its sequences are mapped onto every resident
+trie, and every resident genome's sequences are mapped onto a trie of
+the query, spread over all threads.
+*/
+vector<double> compareQuery(ResidentGenomes &genomes, const string &queryFile) {
+
+	int seqLen = genomes.sequenceLength;
+
+	string querySequences = getQuerySequences(queryFile, seqLen);
+
+	GenomeTrie queryTrie;
+
+	buildTrie(queryFile, queryTrie, seqLen);
+
+	vector<double> homologies(genomes.files.size());
+
+	parallelFor(genomes.files.size(), 1, genomes.numThreads, [&](size_t begin, size_t end, int) {
+
+		for (size_t i = begin; i < end; ++i) {
+
+			double forward = getMappedProportion(querySequences, *genomes.tries[i], seqLen);
+			double backward = getMappedProportion(genomes.sequences[i], queryTrie, seqLen);
+
+			homologies[i] = pairHomology(forward, backward);
+		}
+	});
+
+	return homologies;
+}
+
+//Return the containment of the query genome in every family, best family first
+string classifyQuery(ResidentGenomes &genomes, const string &queryFile) {
+
+	FamilyIndex *index = genomes.familyIndex.get();
+
+	if (!index)
+		return "ERROR no family index loaded\n";
+
+	vector<double> containment, support;
+
+	int best = index->classify(queryFile, containment, support);
+
+	if (best == -1)
+		return "ERROR could not classify " + queryFile + "\n";
+
+	string response = queryFile + '\t' + index->getFamilyName(best) + '\t'
+		+ to_string(containment[best] * 100) + '\n';
+
+	vector<unsigned int> order(index->numFamilies());
+	iota(order.begin(), order.end(), 0);
+
+	stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) {
+		return containment[a] > containment[b];
+	});
+
+	for (unsigned int f : order)
+		response += '\t' + index->getFamilyName(f) + '\t' + to_string(containment[f] * 100)
+			+ '\t' + to_string(support[f] * 100) + '\t' + to_string(index->getFamilySize(f)) + '\n';
+
+	return response;
+}
+
+//Answer a single request. Set shutdown to true if the server should stop.
+string answer(ResidentGenomes &genomes, const string &request, bool &shutdown) {
+
+	size_t space = request.find(' ');
+
+	string command = request.substr(0, space);
+	string argument = space == string::npos ? "" : request.substr(space + 1);
+
+	if (command == "SHUTDOWN") {
+		shutdown = true;
+		return "OK\n";
+	}
+
+	if (command != "COMPARE" && command != "FAMILY" && command != "CLASSIFY")
+		return "ERROR unknown request " + command + "\n";
+
+	if (!ifstream(argument))
+		return "ERROR could not read " + argument + "\n";
+
+	if (command == "CLASSIFY")
+		return classifyQuery(genomes, argument);
+
+	vector<double> homologies = compareQuery(genomes, argument);
+
+	string response = "";
+
+	if (command == "COMPARE") {
+
+		for (unsigned int i = 0; i < genomes.files.size(); ++i)
+			response += genomes.files[i] + '\t' + argument + '\t' + to_string(homologies[i]) + '\n';
+
+		return response;
+	}
+
+	//Find the most homologous genome that has a family
+	int best = -1;
+
+	for (unsigned int i = 0; i < genomes.files.size(); ++i)
+		if (genomes.families[i] != "" && (best == -1 || homologies[i] > homologies[best]))
+			best = i;
+
+	if (best == -1)
+		return "ERROR no families loaded\n";
+
+	return genomes.families[best] + '\t' + genomes.files[best] + '\t'
+		+ to_string(homologies[best]) + '\n';
+}
+
+int main(int argc, char** argv) {
+
+	if (argc < 5) {
+		cout << "usage: ./genomeserver genome_directory file_names sequence_length "
+			<< "socket_path [--families FILE] [--threads N]" << endl;
+		return -1;
+	}
+
+	string genome_directory = argv[1];
+	string file_names = argv[2];
+	string socket_path = argv[4];
+
+	ResidentGenomes genomes;
+
+	genomes.sequenceLength = atoi(argv[3]);
+	genomes.numThreads = defaultThreads();
+
+	string families_file = "";
+
+	for (int i = 5; i < argc; ++i) {
+
+		if (!strcmp(argv[i], "--families") && i + 1 < argc)
+			families_file = argv[++i];
+		else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+			genomes.numThreads = atoi(argv[++i]);
+		else {
+			cout << "unknown option " << argv[i] << endl;
+			return -1;
+		}
+	}
+
+	if (genomes.sequenceLength < 1) {
+		cout << "sequence length must be at least 1" << endl;
+		return -1;
+	}
+
+	if (genomes.numThreads < 1) {
+		cout << "number of threads must be at least 1" << endl;
+		return -1;
+	}
+
+	//A client that goes away early must not stop the server
+	signal(SIGPIPE, SIG_IGN);
+
+	genomes.files = getFileNames(genome_directory, file_names);
+
+	cout << "Building tries for " << genomes.files.size() << " genomes" << endl;
+	loadGenomes(genomes);
+
+	//Look up the family of every genome
+	genomes.families.assign(genomes.files.size(), "");
+
+	if (families_file != "") {
+
+		unordered_map<string, string> familyOf;
+
+		vector<pair<string, vector<string>>> familyList = readFamilies(families_file);
+
+		for (auto &family : familyList)
+			for (auto &genome : family.second)
+				familyOf[genome] = family.first;
+
+		for (unsigned int i = 0; i < genomes.files.size(); ++i) {
+			auto itr = familyOf.find(genomes.files[i]);
+			if (itr != familyOf.end())
+				genomes.families[i] = itr->second;
+		}
+
+		cout << "Loaded " << familyOf.size() << " family assignments" << endl;
+
+		if (genomes.sequenceLength <= MAX_PACKED_LENGTH) {
+
+			genomes.familyIndex.reset(new FamilyIndex(genomes.sequenceLength, genomes.numThreads));
+
+			string unreadable;
+
+			if (genomes.familyIndex->build(familyList, unreadable)) {
+				cout << "Indexed " << genomes.familyIndex->numSequences() << " sequences of "
+					<< genomes.familyIndex->numFamilies() << " families" << endl;
+			}
+			else {
+				cout << "could not read " << unreadable << ", CLASSIFY is disabled" << endl;
+				genomes.familyIndex.reset();
+			}
+		}
+	}
+
+	int server = listenLocal(socket_path);
+
+	if (server < 0) {
+		cout << "could not listen on " << socket_path << ": " << strerror(errno) << endl;
+		return -1;
+	}
+
+	cout << "Listening on " << socket_path << endl;
+
+	//Answer one request per connection
+	bool shutdown = false;
+	int status = 0;
+
+	while (!shutdown) {
+
+		int client = accept(server, nullptr, nullptr);
+
+		//Retry after a signal or a client that gave up, stop on errors that would repeat
+		if (client < 0) {
+
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+
+			cout << "could not accept a connection: " << strerror(errno) << endl;
+			status = -1;
+			break;
+		}
+
+		//A client that sends nothing, or never reads its answer, can't hold up the others
+		setTimeout(client, CLIENT_TIMEOUT);
+
+		string request;
+
+		if (readLine(client, request)) {
+
+			auto start = chrono::steady_clock::now();
+
+			writeAll(client, answer(genomes, request, shutdown));
+
+			chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+			cout << request << " answered in " << elapsed.count() << "s" << endl;
+		}
+
+		close(client);
+	}
+
+	close(server);
+	unlink(socket_path.c_str());
+
+	cout << "Server stopped" << endl;
+
+	return status;
+}
\ No newline at end of file